@@ -0,0 +1,110 @@
+// Benchmarks for the bigint_asm programs.
+// Each iteration starts the program, feeds two decimal operands to stdin and reads
+// the result, so the timings include process start-up and the programs' own
+// quadratic decimal conversion. spawn/1 measures that floor with tiny operands.
+// Operands are limited to 128 qwords (256 limbs) by the programs themselves.
+
+#include "harness.h"
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+	volatile size_t sink;
+
+	std::mt19937 rng(20240229);
+
+	std::string random_digits(size_t limbs) {
+		size_t digits = static_cast<size_t>(limbs * 9.632959861247398);
+		std::string res(digits, '0');
+		res[0] = static_cast<char>('1' + rng() % 9);
+		for (size_t i = 1; i < digits; ++i) {
+			res[i] = static_cast<char>('0' + rng() % 10);
+		}
+		return res;
+	}
+
+	// runs program with input on stdin, returns its stdout
+	std::string run(std::string const &program, std::string const &input) {
+		int in[2], out[2];
+		if (pipe(in) != 0 || pipe(out) != 0) {
+			throw std::runtime_error("pipe failed");
+		}
+		pid_t pid = fork();
+		if (pid < 0) {
+			throw std::runtime_error("fork failed");
+		}
+		if (pid == 0) {
+			dup2(in[0], 0);
+			dup2(out[1], 1);
+			close(in[0]);
+			close(in[1]);
+			close(out[0]);
+			close(out[1]);
+			execl(program.c_str(), program.c_str(), static_cast<char *>(nullptr));
+			_exit(127);
+		}
+		close(in[0]);
+		close(out[1]);
+		// inputs are a few KiB, well below the pipe capacity
+		for (size_t written = 0; written < input.size();) {
+			ssize_t n = write(in[1], input.data() + written, input.size() - written);
+			if (n <= 0) {
+				break;
+			}
+			written += static_cast<size_t>(n);
+		}
+		close(in[1]);
+		std::string res;
+		char buffer[4096];
+		for (ssize_t n; (n = read(out[0], buffer, sizeof buffer)) > 0;) {
+			res.append(buffer, static_cast<size_t>(n));
+		}
+		close(out[0]);
+		int status;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+			throw std::runtime_error("cannot run " + program);
+		}
+		return res;
+	}
+}
+
+int main(int argc, char **argv) {
+	std::string dir = ".";
+	// --asm_dir is ours, everything else goes to the runner
+	std::vector<char *> args;
+	for (int i = 0; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg.compare(0, 10, "--asm_dir=") == 0) {
+			dir = arg.substr(10);
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+	bench::runner runner(static_cast<int>(args.size()), args.data(), "bigint_asm");
+
+	std::string sub = dir + "/asm_sub";
+	std::string mul = dir + "/asm_mul";
+
+	runner.sweep("spawn", [&](size_t) {
+		return [&] { sink = sink + run(sub, "0\n0\n").size(); };
+	}, 1, 2, 1);
+
+	for (auto program : {std::make_pair("sub", sub), std::make_pair("mul", mul)}) {
+		std::string const path = program.second;
+		runner.sweep(program.first, [&](size_t limbs) {
+			std::string input = random_digits(limbs) + "\n" + random_digits(limbs) + "\n";
+			return [=] { sink = sink + run(path, input).size(); };
+		}, 2, 2, 256);
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,500 @@
+// Operator, conversion and expression benchmarks.
+// Built once per implementation (bigint and bigint_opt); BENCH_LIBRARY names it.
+// Only non-negative operands are used, the bigint variant is not reliable for negative ones.
+
+#include "big_integer.h"
+#include "harness.h"
+
+#ifdef BENCH_BIGINT_OPT
+#include "accumulator.h"
+#include "batch.h"
+#include "expression.h"
+#include "fixed_big_integer.h"
+#include "ifma.h"
+#include "limbs.h"
+#include "multi_mod.h"
+#include "parallel.h"
+#include "primes.h"
+#include "rns.h"
+#include "serialize.h"
+#endif
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_LIBRARY
+#define BENCH_LIBRARY "unknown"
+#endif
+
+namespace {
+	volatile size_t sink;
+
+	std::mt19937 rng(20240229);
+
+	// number with exactly limbs 32-bit chunks
+	big_integer random_number(size_t limbs) {
+		if (limbs == 1) {
+			return big_integer(static_cast<std::uint32_t>(rng() | 1));
+		}
+		size_t low = limbs / 2;
+		big_integer high = random_number(limbs - low);
+		return (high << static_cast<int>(32 * low)) + random_number(low);
+	}
+
+	// decimal string of about the same magnitude as a limbs-chunk number
+	std::string random_digits(size_t limbs) {
+		size_t digits = static_cast<size_t>(limbs * 9.632959861247398) + 1;
+		std::string res(digits, '0');
+		res[0] = static_cast<char>('1' + rng() % 9);
+		for (size_t i = 1; i < digits; ++i) {
+			res[i] = static_cast<char>('0' + rng() % 10);
+		}
+		return res;
+	}
+
+	template<typename Operation>
+	void binary(bench::runner &runner, std::string const &name, size_t lhs_scale, Operation operation) {
+		runner.sweep(name, [=](size_t limbs) {
+			big_integer a = random_number(limbs * lhs_scale);
+			big_integer b = random_number(limbs);
+			return [=] { sink = sink + operation(a, b).get_data_size(); };
+		});
+	}
+
+#ifdef BENCH_BIGINT_OPT
+	constexpr size_t BATCH_SIZE = 1024;
+
+	big_integer_batch random_batch(size_t limbs) {
+		big_integer_batch res(BATCH_SIZE, limbs);
+		for (size_t i = 0; i != limbs; ++i) {
+			for (size_t j = 0; j != BATCH_SIZE; ++j) {
+				res.chunk(i)[j] = static_cast<std::uint32_t>(rng());
+			}
+		}
+		return res;
+	}
+
+	// BATCH_SIZE elements of limbs chunks each, with one kernel forced
+	void batch_sweeps(bench::runner &runner, batch::kernel kernel) {
+		std::string suffix = std::string("_") + batch::name(kernel);
+		runner.sweep("batch/add" + suffix, [=](size_t limbs) {
+			batch::select(kernel);
+			big_integer_batch a = random_batch(limbs), b = random_batch(limbs), r(BATCH_SIZE, limbs);
+			return [=]() mutable {
+				batch::add(r, a, b);
+				sink = sink + r.chunk(limbs - 1)[0];
+			};
+		}, 8, 2, 64);
+		runner.sweep("batch/sub" + suffix, [=](size_t limbs) {
+			batch::select(kernel);
+			big_integer_batch a = random_batch(limbs), b = random_batch(limbs), r(BATCH_SIZE, limbs);
+			return [=]() mutable {
+				batch::sub(r, a, b);
+				sink = sink + r.chunk(limbs - 1)[0];
+			};
+		}, 8, 2, 64);
+		runner.sweep("batch/mul_1" + suffix, [=](size_t limbs) {
+			batch::select(kernel);
+			big_integer_batch a = random_batch(limbs), r(BATCH_SIZE, limbs);
+			return [=]() mutable {
+				batch::mul_1(r, a, 1000000007);
+				sink = sink + r.chunk(limbs - 1)[0];
+			};
+		}, 8, 2, 64);
+		runner.sweep("batch/cmp" + suffix, [=](size_t limbs) {
+			batch::select(kernel);
+			big_integer_batch a = random_batch(limbs), b = a;
+			std::vector<int> res(BATCH_SIZE);
+			return [=]() mutable {
+				batch::cmp(res.data(), a, b);
+				sink = sink + res[0];
+			};
+		}, 8, 2, 64);
+	}
+
+	std::vector<std::uint32_t> random_chunks(size_t chunks) {
+		std::vector<std::uint32_t> res(chunks);
+		for (std::uint32_t &chunk : res) {
+			chunk = static_cast<std::uint32_t>(rng());
+		}
+		return res;
+	}
+
+	// the limbs.h kernels with the IFMA paths on or off; without IFMA support
+	// both run the scalar code
+	void ifma_sweeps(bench::runner &runner, bool use) {
+		std::string suffix = use ? "_ifma" : "_scalar";
+		runner.sweep("ifma/mul" + suffix, [=](size_t chunks) {
+			ifma::select(use);
+			std::vector<std::uint32_t> a = random_chunks(chunks), b = random_chunks(chunks), r(2 * chunks);
+			return [=]() mutable {
+				limbs::mul(r.data(), a.data(), chunks, b.data(), chunks);
+				sink = sink + r[chunks];
+			};
+		}, 4, 2, 2048);
+		// a = a * b / R mod m, as in the prime tests
+		runner.sweep("ifma/mont_mul" + suffix, [=](size_t chunks) {
+			ifma::select(use);
+			std::vector<std::uint32_t> m = random_chunks(chunks), a = random_chunks(chunks), b = random_chunks(chunks);
+			m[0] |= 1;
+			m[chunks - 1] |= 0x80000000u;
+			a[chunks - 1] &= 0x7FFFFFFFu;
+			b[chunks - 1] &= 0x7FFFFFFFu;
+			std::uint32_t m_inv = 0 - limbs::inverse_mod_base(m[0]);
+			std::vector<std::uint32_t> scratch(chunks + 2);
+			std::shared_ptr<ifma::montgomery> fast;
+			if (ifma::active()) {
+				fast = std::make_shared<ifma::montgomery>(m.data(), chunks);
+			}
+			return [=]() mutable {
+				if (fast) {
+					fast->mul(a.data(), a.data(), b.data());
+				}
+				else {
+					limbs::mont_mul(a.data(), a.data(), b.data(), m.data(), chunks, m_inv, scratch.data());
+				}
+				sink = sink + a[0];
+			};
+		}, 4, 2, 512);
+		ifma::select(true);
+	}
+
+	// a limbs-chunk number modulo the first 1000 primes
+	void multi_mod_sweeps(bench::runner &runner) {
+		std::vector<std::uint32_t> primes = primes_up_to(7919);
+		runner.sweep("multi_mod", [=](size_t limbs) {
+			big_integer a = random_number(limbs);
+			return [=] { sink = sink + multi_mod(a, primes)[0]; };
+		});
+		runner.sweep("multi_mod_loop", [=](size_t limbs) {
+			big_integer a = random_number(limbs);
+			return [=] {
+				for (std::uint32_t p : primes) {
+					sink = sink + (a % big_integer(p)).get_chunk(0);
+				}
+			};
+		});
+	}
+
+	// RNS_BATCH products of two limbs-chunk numbers, exact in a context of 64 limbs bits
+	constexpr size_t RNS_BATCH = 64;
+
+	void rns_sweeps(bench::runner &runner) {
+		runner.sweep("rns/mul", [](size_t limbs) {
+			auto context = std::make_shared<rns_context>(64 * limbs);
+			size_t size = context->size();
+			std::vector<std::uint32_t> a(RNS_BATCH * size), b(RNS_BATCH * size), r(RNS_BATCH * size);
+			for (size_t j = 0; j != RNS_BATCH; ++j) {
+				context->to_rns(a.data() + j * size, random_number(limbs));
+				context->to_rns(b.data() + j * size, random_number(limbs));
+			}
+			return [=]() mutable {
+				context->mul(r.data(), a.data(), b.data(), RNS_BATCH);
+				sink = sink + r[0];
+			};
+		}, 1, 4, 1024);
+		runner.sweep("rns/mul_big_integer", [](size_t limbs) {
+			std::vector<big_integer> a, b;
+			for (size_t j = 0; j != RNS_BATCH; ++j) {
+				a.push_back(random_number(limbs));
+				b.push_back(random_number(limbs));
+			}
+			return [=] {
+				for (size_t j = 0; j != RNS_BATCH; ++j) {
+					sink = sink + (a[j] * b[j]).get_data_size();
+				}
+			};
+		}, 1, 4, 1024);
+		// conversions of a single number
+		runner.sweep("rns/to_rns", [](size_t limbs) {
+			auto context = std::make_shared<rns_context>(64 * limbs);
+			big_integer a = random_number(2 * limbs);
+			std::vector<std::uint32_t> r(context->size());
+			return [=]() mutable {
+				context->to_rns(r.data(), a);
+				sink = sink + r[0];
+			};
+		}, 1, 4, 1024);
+		runner.sweep("rns/from_rns", [](size_t limbs) {
+			auto context = std::make_shared<rns_context>(64 * limbs);
+			std::vector<std::uint32_t> r = context->to_rns(random_number(2 * limbs));
+			return [=] { sink = sink + context->from_rns(r).get_data_size(); };
+		}, 1, 4, 1024);
+	}
+
+	// one size only, the width of Fixed; mul_add_dynamic is the same recurrence on big_integer
+	template<typename Fixed>
+	void fixed(bench::runner &runner) {
+		size_t chunks = Fixed::CHUNKS;
+		runner.sweep("fixed/mul_add", [](size_t) {
+			Fixed a(random_number(Fixed::CHUNKS)), b(random_number(Fixed::CHUNKS));
+			// a feeds back into itself, or the compiler hoists the whole expression
+			return [=]() mutable {
+				a = a * b + b;
+				sink = sink + a.get_chunk(Fixed::CHUNKS - 1);
+			};
+		}, chunks, 4, chunks);
+		runner.sweep("fixed/mul_add_dynamic", [](size_t) {
+			big_integer a = random_number(Fixed::CHUNKS), b = random_number(Fixed::CHUNKS);
+			big_integer modulus = big_integer(1) << static_cast<int>(32 * Fixed::CHUNKS);
+			return [=]() mutable {
+				a = (a * b + b) % modulus;
+				sink = sink + a.get_chunk(Fixed::CHUNKS - 1);
+			};
+		}, chunks, 4, chunks);
+	}
+#endif
+}
+
+int main(int argc, char **argv) {
+	bench::runner runner(argc, argv, BENCH_LIBRARY);
+
+	binary(runner, "add", 1, [](big_integer const &a, big_integer const &b) { return a + b; });
+	binary(runner, "sub", 1, [](big_integer const &a, big_integer const &b) { return a - b; });
+	binary(runner, "mul", 1, [](big_integer const &a, big_integer const &b) { return a * b; });
+	binary(runner, "sqr", 1, [](big_integer const &a, big_integer const &) { return a * a; });
+#ifdef BENCH_BIGINT_OPT
+	// one thread per hardware thread; sequential below PARALLEL_MUL_THRESHOLD
+	binary(runner, "mul_parallel", 1, [](big_integer const &a, big_integer const &b) { return mul(a, b, parallel::policy()); });
+#endif
+	binary(runner, "div", 2, [](big_integer const &a, big_integer const &b) { return a / b; });
+	binary(runner, "mod", 2, [](big_integer const &a, big_integer const &b) { return a % b; });
+	binary(runner, "div_short", 1, [](big_integer const &a, big_integer const &) { return a / 1000000007; });
+#ifdef BENCH_BIGINT_OPT
+	// a multiple of b of twice its size, as for div above
+	runner.sweep("divexact", [](size_t limbs) {
+		big_integer b = random_number(limbs);
+		big_integer a = random_number(limbs) * b;
+		return [=] { sink = sink + divexact(a, b).get_data_size(); };
+	});
+	runner.sweep("divisible_by", [](size_t limbs) {
+		big_integer b = random_number(limbs);
+		big_integer a = random_number(limbs) * b;
+		return [=] { sink = sink + divisible_by(a, b); };
+	});
+#endif
+	binary(runner, "and", 1, [](big_integer const &a, big_integer const &b) { return a & b; });
+	binary(runner, "or", 1, [](big_integer const &a, big_integer const &b) { return a | b; });
+	binary(runner, "xor", 1, [](big_integer const &a, big_integer const &b) { return a ^ b; });
+	binary(runner, "shl", 1, [](big_integer const &a, big_integer const &) { return a << 100; });
+	binary(runner, "shr", 1, [](big_integer const &a, big_integer const &) { return a >> 100; });
+	binary(runner, "negate", 1, [](big_integer const &a, big_integer const &) { return -a; });
+
+	runner.sweep("cmp", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		big_integer b = a + 1;
+		return [=] { sink = sink + (a < b) + (a == b); };
+	});
+
+	runner.sweep("to_string", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		return [=] { sink = sink + to_string(a).size(); };
+	});
+
+	runner.sweep("parse", [](size_t limbs) {
+		std::string s = random_digits(limbs);
+		return [=] { sink = sink + big_integer(s).get_data_size(); };
+	});
+
+	runner.sweep("parse_stream", [](size_t limbs) {
+		std::string s = random_digits(limbs);
+		return [=] {
+			std::istringstream in(s);
+			big_integer a;
+			in >> a;
+			sink = sink + a.get_data_size();
+		};
+	});
+
+#ifdef BENCH_BIGINT_OPT
+	runner.sweep("to_string_parallel", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		return [=] { sink = sink + to_string(a, parallel::policy()).size(); };
+	});
+
+	runner.sweep("parse_parallel", [](size_t limbs) {
+		std::string s = random_digits(limbs);
+		return [=] { sink = sink + big_integer(s, parallel::policy()).get_data_size(); };
+	});
+
+	// binary records, against to_string and parse above
+	runner.sweep("serialize", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		return [=] { sink = sink + serialize(a).size(); };
+	});
+
+	runner.sweep("deserialize", [](size_t limbs) {
+		std::vector<std::uint8_t> bytes = serialize(random_number(limbs));
+		return [=] { sink = sink + deserialize(bytes).get_data_size(); };
+	});
+
+	runner.sweep("deserialize_adopt", [](size_t limbs) {
+		auto bytes = std::make_shared<std::vector<std::uint8_t>>(serialize(random_number(limbs)));
+		return [=] {
+			big_integer a;
+			deserialize(a, bytes->data(), bytes->data() + bytes->size(), bytes);
+			sink = sink + a.get_data_size();
+		};
+	});
+#endif
+
+	// copies and in-place updates: where small-buffer and copy-on-write storage matter
+	runner.sweep("copy", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		return [=] {
+			big_integer b = a;
+			sink = sink + b.get_data_size();
+		};
+	});
+
+	runner.sweep("copy_modify", [](size_t limbs) {
+		big_integer a = random_number(limbs);
+		return [=] {
+			big_integer b = a;
+			b += 1;
+			sink = sink + b.get_data_size();
+		};
+	});
+
+	runner.sweep("expr/fused", [](size_t limbs) {
+		big_integer a = random_number(limbs), b = random_number(limbs), c = random_number(limbs),
+			d = random_number(limbs), e = random_number(limbs);
+		return [=] { sink = sink + (a * b + c * d - e).get_data_size(); };
+	});
+
+#ifdef BENCH_BIGINT_OPT
+	runner.sweep("expr/fused_lazy", [](size_t limbs) {
+		big_integer a = random_number(limbs), b = random_number(limbs), c = random_number(limbs),
+			d = random_number(limbs), e = random_number(limbs);
+		return [=] { sink = sink + expr::eval(expr::lazy(a) * b + expr::lazy(c) * d - e).get_data_size(); };
+	});
+#endif
+
+	runner.sweep("expr/chain", [](size_t limbs) {
+		big_integer a = random_number(limbs), b = random_number(limbs), c = random_number(limbs);
+		return [=] { sink = sink + ((((a + b) - c) * 3 + (a >> 5)) / 7 ^ b).get_data_size(); };
+	});
+
+	runner.sweep("expr/accumulate", [](size_t limbs) {
+		std::vector<big_integer> values;
+		for (size_t i = 0; i < 64; ++i) {
+			values.push_back(random_number(limbs));
+		}
+		return [=] {
+			big_integer acc = 0;
+			for (big_integer const &v : values) {
+				acc += v;
+				acc *= 3;
+			}
+			sink = sink + acc.get_data_size();
+		};
+	});
+
+	runner.sweep("expr/dot", [](size_t limbs) {
+		std::vector<big_integer> a, b;
+		for (size_t i = 0; i < 16; ++i) {
+			a.push_back(random_number(limbs));
+			b.push_back(random_number(limbs));
+		}
+		return [=] {
+			big_integer acc = 0;
+			for (size_t i = 0; i != a.size(); ++i) {
+				acc += a[i] * b[i];
+			}
+			sink = sink + acc.get_data_size();
+		};
+	});
+
+#ifdef BENCH_BIGINT_OPT
+	runner.sweep("expr/dot_addmul", [](size_t limbs) {
+		std::vector<big_integer> a, b;
+		for (size_t i = 0; i < 16; ++i) {
+			a.push_back(random_number(limbs));
+			b.push_back(random_number(limbs));
+		}
+		return [=] {
+			big_integer acc = 0;
+			for (size_t i = 0; i != a.size(); ++i) {
+				addmul(acc, a[i], b[i]);
+			}
+			sink = sink + acc.get_data_size();
+		};
+	});
+#endif
+
+	runner.sweep("expr/sum", [](size_t limbs) {
+		std::vector<big_integer> values;
+		for (size_t i = 0; i < 256; ++i) {
+			values.push_back(random_number(limbs));
+		}
+		return [=] {
+			big_integer acc = 0;
+			for (big_integer const &v : values) {
+				acc += v;
+			}
+			sink = sink + acc.get_data_size();
+		};
+	});
+
+#ifdef BENCH_BIGINT_OPT
+	runner.sweep("expr/sum_accumulator", [](size_t limbs) {
+		std::vector<big_integer> values;
+		for (size_t i = 0; i < 256; ++i) {
+			values.push_back(random_number(limbs));
+		}
+		return [=] {
+			big_accumulator acc;
+			for (big_integer const &v : values) {
+				acc += v;
+			}
+			sink = sink + acc.finalize().get_data_size();
+		};
+	});
+#endif
+
+#ifdef BENCH_BIGINT_OPT
+	// batch kernels against operator+= on each element; a kernel the CPU lacks
+	// falls back to the next narrower one
+	runner.sweep("batch/add_elementwise", [](size_t limbs) {
+		std::vector<big_integer> a, b;
+		for (size_t j = 0; j != BATCH_SIZE; ++j) {
+			a.push_back(random_number(limbs));
+			b.push_back(random_number(limbs));
+		}
+		return [=]() mutable {
+			for (size_t j = 0; j != BATCH_SIZE; ++j) {
+				a[j] += b[j];
+			}
+			sink = sink + a[0].get_data_size();
+		};
+	}, 8, 2, 64);
+	batch_sweeps(runner, batch::kernel::scalar);
+	batch_sweeps(runner, batch::kernel::avx2);
+	batch_sweeps(runner, batch::kernel::avx512);
+
+	multi_mod_sweeps(runner);
+	rns_sweeps(runner);
+
+	ifma_sweeps(runner, false);
+	ifma_sweeps(runner, true);
+
+	fixed<fixed_uint<256>>(runner);
+	fixed<fixed_uint<1024>>(runner);
+#endif
+
+	runner.sweep("expr/horner", [](size_t limbs) {
+		return [=] {
+			big_integer x = 1;
+			for (size_t i = 0; i < limbs * 20; ++i) {
+				x = x * 3 + 1;
+			}
+			sink = sink + x.get_data_size();
+		};
+	});
+
+	return runner.finish();
+}
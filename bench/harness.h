@@ -0,0 +1,216 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+// A small stand-in for Google Benchmark: size sweeps, a console table and
+// JSON output in Google Benchmark's schema, so that existing comparison
+// scripts (compare.py and the like) can read the results.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace bench {
+	struct options {
+		std::string filter = ".*";
+		std::string out;
+		double min_time = 0.2;		// seconds per measurement
+		double max_time = 1.0;		// a sweep stops once one call takes longer than this
+		size_t max_limbs = size_t(1) << 20;
+	};
+
+	struct result {
+		std::string name;
+		size_t limbs;
+		size_t iterations;
+		double real_time;		// ns per iteration
+		double cpu_time;		// ns per iteration
+	};
+
+	// process CPU time, including waited-for children
+	inline double cpu_seconds() {
+#if defined(__unix__) || defined(__APPLE__)
+		double total = 0;
+		for (int who : {RUSAGE_SELF, RUSAGE_CHILDREN}) {
+			rusage usage;
+			getrusage(who, &usage);
+			total += usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+				+ 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+		}
+		return total;
+#else
+		return double(std::clock()) / CLOCKS_PER_SEC;
+#endif
+	}
+
+	inline double real_seconds() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	class runner {
+	public:
+		runner(int argc, char **argv, std::string library)
+			: executable(argv[0]), library(std::move(library)) {
+			for (int i = 1; i < argc; ++i) {
+				std::string arg = argv[i];
+				if (!parse_flag(arg)) {
+					std::cerr << "unknown argument: " << arg << "\n"
+						"flags: --benchmark_filter=<regex> --benchmark_out=<file> --benchmark_min_time=<s>\n"
+						"       --max_time=<s> --max_limbs=<n>\n";
+					std::exit(1);
+				}
+			}
+			std::printf("%-32s %16s %16s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+		}
+
+		options const &settings() const {
+			return opts;
+		}
+
+		// runs setup(limbs) for limbs = first, first * factor, ... <= min(last, max_limbs)
+		// and times the callable it returns
+		template<typename Setup>
+		void sweep(std::string const &name, Setup setup, size_t first = 1, size_t factor = 4, size_t last = size_t(-1)) {
+			last = std::min(last, opts.max_limbs);
+			for (size_t limbs = first; limbs <= last; limbs *= factor) {
+				std::string full_name = name + "/" + std::to_string(limbs);
+				if (!std::regex_search(full_name, filter)) {
+					continue;
+				}
+				auto body = setup(limbs);
+				result r = measure(full_name, limbs, body);
+				report(r);
+				// the next size is at least factor times slower
+				if (r.real_time * 1e-9 * factor > opts.max_time) {
+					break;
+				}
+			}
+		}
+
+		// writes the JSON file if one was requested, returns the exit code
+		int finish() const {
+			if (opts.out.empty()) {
+				return 0;
+			}
+			std::ofstream out(opts.out);
+			if (!out) {
+				std::cerr << "cannot open " << opts.out << "\n";
+				return 1;
+			}
+			char date[64];
+			std::time_t now = std::time(nullptr);
+			std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+			out << "{\n  \"context\": {\n"
+				<< "    \"date\": \"" << date << "\",\n"
+				<< "    \"executable\": \"" << escape(executable) << "\",\n"
+				<< "    \"library\": \"" << escape(library) << "\",\n"
+				<< "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+				<< "    \"library_build_type\": \"release\"\n"
+#else
+				<< "    \"library_build_type\": \"debug\"\n"
+#endif
+				<< "  },\n  \"benchmarks\": [";
+			for (size_t i = 0; i < results.size(); ++i) {
+				result const &r = results[i];
+				out << (i ? ",\n" : "\n")
+					<< "    {\n"
+					<< "      \"name\": \"" << escape(r.name) << "\",\n"
+					<< "      \"run_name\": \"" << escape(r.name) << "\",\n"
+					<< "      \"run_type\": \"iteration\",\n"
+					<< "      \"iterations\": " << r.iterations << ",\n"
+					<< "      \"real_time\": " << r.real_time << ",\n"
+					<< "      \"cpu_time\": " << r.cpu_time << ",\n"
+					<< "      \"time_unit\": \"ns\",\n"
+					<< "      \"limbs\": " << r.limbs << "\n"
+					<< "    }";
+			}
+			out << "\n  ]\n}\n";
+			return out ? 0 : 1;
+		}
+
+	private:
+		options opts;
+		std::regex filter {".*"};
+		std::string executable;
+		std::string library;
+		std::vector<result> results;
+
+		bool parse_flag(std::string const &arg) {
+			auto value = [&](char const *flag, std::string &to) {
+				std::string prefix = std::string(flag) + "=";
+				if (arg.compare(0, prefix.size(), prefix) != 0) {
+					return false;
+				}
+				to = arg.substr(prefix.size());
+				return true;
+			};
+			std::string v;
+			if (value("--benchmark_filter", v)) {
+				opts.filter = v;
+				filter = std::regex(v);
+			} else if (value("--benchmark_out", v)) {
+				opts.out = v;
+			} else if (value("--benchmark_min_time", v)) {
+				opts.min_time = std::atof(v.c_str());
+			} else if (value("--max_time", v)) {
+				opts.max_time = std::atof(v.c_str());
+			} else if (value("--max_limbs", v)) {
+				opts.max_limbs = std::strtoull(v.c_str(), nullptr, 10);
+			} else {
+				return false;
+			}
+			return true;
+		}
+
+		// like Google Benchmark: grow the iteration count until a run lasts min_time
+		template<typename Body>
+		result measure(std::string const &name, size_t limbs, Body &body) {
+			size_t iterations = 1;
+			for (;;) {
+				double cpu_start = cpu_seconds();
+				double real_start = real_seconds();
+				for (size_t i = 0; i < iterations; ++i) {
+					body();
+				}
+				double real = real_seconds() - real_start;
+				double cpu = cpu_seconds() - cpu_start;
+				if (real >= opts.min_time || iterations >= 1000000000) {
+					return {name, limbs, iterations, real * 1e9 / iterations, cpu * 1e9 / iterations};
+				}
+				double grow = real > 0 ? opts.min_time * 1.4 / real : 10;
+				iterations = size_t(iterations * std::max(2.0, std::min(10.0, grow)));
+			}
+		}
+
+		void report(result const &r) {
+			std::printf("%-32s %16.0f %16.0f %12zu\n", r.name.c_str(), r.real_time, r.cpu_time, r.iterations);
+			std::fflush(stdout);
+			results.push_back(r);
+		}
+
+		static std::string escape(std::string const &s) {
+			std::string res;
+			for (char c : s) {
+				if (c == '"' || c == '\\') {
+					res += '\\';
+				}
+				res += c;
+			}
+			return res;
+		}
+	};
+}
+
+#endif // BENCH_HARNESS_H
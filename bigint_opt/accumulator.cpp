@@ -0,0 +1,108 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "accumulator.h"
+#include "my_vector.h"
+
+#include <algorithm>
+
+using uint = std::uint32_t;
+
+extern const uint CHUNK_BIT_SIZE;
+
+namespace {
+	// a normalized slot is below 2^32, so this many chunks can be added to it
+	constexpr std::uint64_t MAX_PENDING = UINT32_MAX;
+}
+
+big_accumulator::big_accumulator()
+	: pending(0) {
+}
+
+big_accumulator &big_accumulator::operator+=(big_integer const &x) {
+	if (x.signum != 0) {
+		add(x.signum > 0 ? positive : negative, x);
+	}
+	return *this;
+}
+
+big_accumulator &big_accumulator::operator-=(big_integer const &x) {
+	if (x.signum != 0) {
+		add(x.signum > 0 ? negative : positive, x);
+	}
+	return *this;
+}
+
+big_integer big_accumulator::finalize()
+{
+	normalize();
+	big_integer res = to_big_integer(positive);
+	res -= to_big_integer(negative);
+	return res;
+}
+
+void big_accumulator::clear()
+{
+	positive.clear();
+	negative.clear();
+	pending = 0;
+}
+
+void big_accumulator::add(std::vector<ull> &lane, big_integer const &x)
+{
+	if (pending == MAX_PENDING) {
+		normalize();
+	}
+	++pending;
+
+	my_vector const data = x.get_data();
+	size_t n = data.size();
+	if (lane.size() < n) {
+		lane.resize(n, 0);
+	}
+
+	uint const *chunks = data.begin();
+	ull *slots = lane.data();
+	for (size_t i = 0; i != n; ++i) {
+		slots[i] += chunks[i];
+	}
+}
+
+void big_accumulator::normalize()
+{
+	normalize(positive);
+	normalize(negative);
+	pending = 0;
+}
+
+void big_accumulator::normalize(std::vector<ull> &lane)
+{
+	ull carry = 0;
+	for (ull &slot : lane) {
+		carry += slot;
+		slot = carry & UINT32_MAX;
+		carry >>= CHUNK_BIT_SIZE;
+	}
+	while (carry != 0) {
+		lane.push_back(carry & UINT32_MAX);
+		carry >>= CHUNK_BIT_SIZE;
+	}
+}
+
+big_integer big_accumulator::to_big_integer(std::vector<ull> const &lane)
+{
+	size_t n = lane.size();
+	while (n != 0 && lane[n - 1] == 0) {
+		--n;
+	}
+	if (n == 0) {
+		return 0;
+	}
+	my_vector data(n);
+	uint *chunks = data.begin();
+	for (size_t i = 0; i != n; ++i) {
+		chunks[i] = (uint)lane[i];
+	}
+	big_integer res;
+	res.assign_magnitude(data);
+	return res;
+}
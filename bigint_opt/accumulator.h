@@ -0,0 +1,42 @@
+#ifndef BIG_INTEGER_ACCUMULATOR_H
+#define BIG_INTEGER_ACCUMULATOR_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sum of many big_integers with deferred carries.
+// Chunks are added into 64-bit slots without carrying, positive and negative
+// terms into separate lanes, so an addition is a single pass of independent
+// word adds. Carries are propagated by finalize(), and automatically once a
+// slot could overflow (after 2^32 - 1 additions).
+class big_accumulator {
+public:
+	big_accumulator();
+
+	big_accumulator &operator+=(big_integer const &x);
+	big_accumulator &operator-=(big_integer const &x);
+
+	// the sum so far; accumulation can go on afterwards
+	big_integer finalize();
+
+	void clear();
+
+private:
+	using uint = std::uint32_t;
+	using ull = std::uint64_t;
+
+	std::vector<ull> positive;
+	std::vector<ull> negative;
+	// additions since the lanes were last normalized
+	ull pending;
+
+	void add(std::vector<ull> &lane, big_integer const &x);
+	void normalize();
+	static void normalize(std::vector<ull> &lane);
+	static big_integer to_big_integer(std::vector<ull> const &lane);
+};
+
+#endif // BIG_INTEGER_ACCUMULATOR_H
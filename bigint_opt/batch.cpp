@@ -0,0 +1,463 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "batch.h"
+#include "cpu.h"
+#include "fixed_big_integer.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+big_integer_batch::big_integer_batch(size_t count, size_t chunks)
+	: count(count), width(chunks), data(count * chunks, 0) {
+	if (chunks == 0) {
+		throw std::runtime_error("batch elements need at least one chunk");
+	}
+}
+
+void big_integer_batch::set(size_t j, big_integer const &value)
+{
+	std::vector<uint> chunks(width);
+	fixed_detail::from_big_integer(value, chunks.data(), width);
+	for (size_t i = 0; i != width; ++i) {
+		chunk(i)[j] = chunks[i];
+	}
+}
+
+big_integer big_integer_batch::get(size_t j) const
+{
+	std::vector<uint> chunks(width);
+	for (size_t i = 0; i != width; ++i) {
+		chunks[i] = chunk(i)[j];
+	}
+	return fixed_detail::to_big_integer(chunks.data(), width, false);
+}
+
+namespace batch {
+	namespace {
+		// Every kernel works on raw arrays, chunk i of element j at i * count + j,
+		// and goes chunk by chunk so that all accesses are sequential; the carries
+		// of the current chunk wait in a count-sized array (a column is 4 KB for
+		// 1024 elements, walking a whole element at once would hit one cache set
+		// per chunk). The vector kernels do whole vectors of lanes and return how
+		// many elements they did, the scalar ones finish the rest.
+
+		void add_scalar(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *carry, size_t from)
+		{
+			std::vector<uint> carries(count - from, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				size_t offset = i * count;
+				for (size_t j = from; j != count; ++j) {
+					r[offset + j] = limbs::add_with_carry(a[offset + j], b[offset + j], carries[j - from]);
+				}
+			}
+			if (carry != nullptr) {
+				std::copy(carries.begin(), carries.end(), carry + from);
+			}
+		}
+
+		void sub_scalar(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *borrow, size_t from)
+		{
+			std::vector<uint> borrows(count - from, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				size_t offset = i * count;
+				for (size_t j = from; j != count; ++j) {
+					r[offset + j] = limbs::sub_with_borrow(a[offset + j], b[offset + j], borrows[j - from]);
+				}
+			}
+			if (borrow != nullptr) {
+				std::copy(borrows.begin(), borrows.end(), borrow + from);
+			}
+		}
+
+		void mul_1_scalar(uint *r, uint const *a, uint m, size_t count, size_t chunks, uint *carry, size_t from)
+		{
+			std::vector<uint> carries(count - from, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				size_t offset = i * count;
+				for (size_t j = from; j != count; ++j) {
+					r[offset + j] = limbs::mul_add(a[offset + j], m, 0, carries[j - from]);
+				}
+			}
+			if (carry != nullptr) {
+				std::copy(carries.begin(), carries.end(), carry + from);
+			}
+		}
+
+		// from the top chunk down, until every element is decided
+		void cmp_scalar(int *res, uint const *a, uint const *b, size_t count, size_t chunks, size_t from)
+		{
+			std::fill(res + from, res + count, 0);
+			size_t undecided = count - from;
+			for (size_t i = chunks; i-- != 0 && undecided != 0;) {
+				size_t offset = i * count;
+				for (size_t j = from; j != count; ++j) {
+					uint x = a[offset + j], y = b[offset + j];
+					if (res[j] == 0 && x != y) {
+						res[j] = (x > y) ? 1 : -1;
+						--undecided;
+					}
+				}
+			}
+		}
+
+#ifdef HAVE_X86_SIMD
+		// AVX2: 8 lanes, carries as all-ones masks; there is no unsigned compare,
+		// so both sides are compared with their top bit flipped
+
+		SIMD_TARGET("avx2")
+		size_t add_avx2(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *carry)
+		{
+			__m256i const sign = _mm256_set1_epi32(INT32_MIN);
+			__m256i const ones = _mm256_set1_epi32(-1);
+			size_t done = count / 8 * 8;
+			std::vector<uint> carries(done, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 8) {
+					size_t k = i * count + j;
+					__m256i c = _mm256_loadu_si256((__m256i const *)(carries.data() + j));
+					__m256i x = _mm256_loadu_si256((__m256i const *)(a + k));
+					__m256i y = _mm256_loadu_si256((__m256i const *)(b + k));
+					__m256i s = _mm256_add_epi32(x, y);
+					__m256i wrapped = _mm256_cmpgt_epi32(_mm256_xor_si256(x, sign), _mm256_xor_si256(s, sign));
+					__m256i carried = _mm256_and_si256(c, _mm256_cmpeq_epi32(s, ones));
+					_mm256_storeu_si256((__m256i *)(r + k), _mm256_sub_epi32(s, c));
+					_mm256_storeu_si256((__m256i *)(carries.data() + j), _mm256_or_si256(wrapped, carried));
+				}
+			}
+			for (size_t j = 0; carry != nullptr && j != done; ++j) {
+				carry[j] = carries[j] & 1;
+			}
+			return done;
+		}
+
+		SIMD_TARGET("avx2")
+		size_t sub_avx2(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *borrow)
+		{
+			__m256i const sign = _mm256_set1_epi32(INT32_MIN);
+			__m256i const zero = _mm256_setzero_si256();
+			size_t done = count / 8 * 8;
+			std::vector<uint> borrows(done, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 8) {
+					size_t k = i * count + j;
+					__m256i c = _mm256_loadu_si256((__m256i const *)(borrows.data() + j));
+					__m256i x = _mm256_loadu_si256((__m256i const *)(a + k));
+					__m256i y = _mm256_loadu_si256((__m256i const *)(b + k));
+					__m256i d = _mm256_sub_epi32(x, y);
+					__m256i wrapped = _mm256_cmpgt_epi32(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+					__m256i borrowed = _mm256_and_si256(c, _mm256_cmpeq_epi32(d, zero));
+					_mm256_storeu_si256((__m256i *)(r + k), _mm256_add_epi32(d, c));
+					_mm256_storeu_si256((__m256i *)(borrows.data() + j), _mm256_or_si256(wrapped, borrowed));
+				}
+			}
+			for (size_t j = 0; borrow != nullptr && j != done; ++j) {
+				borrow[j] = borrows[j] & 1;
+			}
+			return done;
+		}
+
+		// even and odd lanes go through separate 32 x 32 -> 64 multiplies; the
+		// carries are whole chunks here
+		SIMD_TARGET("avx2")
+		size_t mul_1_avx2(uint *r, uint const *a, uint m, size_t count, size_t chunks, uint *carry)
+		{
+			__m256i const mv = _mm256_set1_epi32((int)m);
+			__m256i const odd_lanes = _mm256_set1_epi64x((long long)0xFFFFFFFF00000000ull);
+			size_t done = count / 8 * 8;
+			std::vector<uint> carries(done, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 8) {
+					size_t k = i * count + j;
+					__m256i c = _mm256_loadu_si256((__m256i const *)(carries.data() + j));
+					__m256i x = _mm256_loadu_si256((__m256i const *)(a + k));
+					__m256i even = _mm256_add_epi64(_mm256_mul_epu32(x, mv), _mm256_andnot_si256(odd_lanes, c));
+					__m256i odd = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), mv), _mm256_srli_epi64(c, 32));
+					_mm256_storeu_si256((__m256i *)(r + k), _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA));
+					_mm256_storeu_si256((__m256i *)(carries.data() + j), _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA));
+				}
+			}
+			if (carry != nullptr) {
+				std::copy(carries.begin(), carries.end(), carry);
+			}
+			return done;
+		}
+
+		SIMD_TARGET("avx2")
+		size_t cmp_avx2(int *res, uint const *a, uint const *b, size_t count, size_t chunks)
+		{
+			__m256i const sign = _mm256_set1_epi32(INT32_MIN);
+			__m256i const one = _mm256_set1_epi32(1);
+			size_t done = count / 8 * 8;
+			std::fill(res, res + done, 0);
+			for (size_t i = chunks; i-- != 0;) {
+				// set once all results are non-zero
+				__m256i all = _mm256_set1_epi32(-1);
+				for (size_t j = 0; j != done; j += 8) {
+					size_t k = i * count + j;
+					__m256i r = _mm256_loadu_si256((__m256i const *)(res + j));
+					__m256i x = _mm256_xor_si256(_mm256_loadu_si256((__m256i const *)(a + k)), sign);
+					__m256i y = _mm256_xor_si256(_mm256_loadu_si256((__m256i const *)(b + k)), sign);
+					__m256i gt = _mm256_cmpgt_epi32(x, y), lt = _mm256_cmpgt_epi32(y, x);
+					__m256i undecided = _mm256_cmpeq_epi32(r, _mm256_setzero_si256());
+					r = _mm256_or_si256(r, _mm256_and_si256(undecided, _mm256_or_si256(_mm256_and_si256(gt, one), lt)));
+					_mm256_storeu_si256((__m256i *)(res + j), r);
+					all = _mm256_andnot_si256(_mm256_cmpeq_epi32(r, _mm256_setzero_si256()), all);
+				}
+				if (_mm256_movemask_epi8(all) == -1) {
+					break;
+				}
+			}
+			return done;
+		}
+
+		// AVX-512: 16 lanes, carries kept as one mask per 16 elements
+
+		SIMD_TARGET("avx512f")
+		size_t add_avx512(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *carry)
+		{
+			__m512i const ones = _mm512_set1_epi32(-1);
+			size_t done = count / 16 * 16;
+			std::vector<__mmask16> carries(done / 16, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 16) {
+					size_t k = i * count + j;
+					__mmask16 c = carries[j / 16];
+					__m512i x = _mm512_loadu_si512(a + k);
+					__m512i s = _mm512_add_epi32(x, _mm512_loadu_si512(b + k));
+					__mmask16 wrapped = _mm512_cmplt_epu32_mask(s, x);
+					__mmask16 carried = _mm512_mask_cmpeq_epi32_mask(c, s, ones);
+					_mm512_storeu_si512(r + k, _mm512_mask_sub_epi32(s, c, s, ones));
+					carries[j / 16] = (__mmask16)(wrapped | carried);
+				}
+			}
+			for (size_t j = 0; carry != nullptr && j != done; j += 16) {
+				_mm512_storeu_si512(carry + j, _mm512_maskz_set1_epi32(carries[j / 16], 1));
+			}
+			return done;
+		}
+
+		SIMD_TARGET("avx512f")
+		size_t sub_avx512(uint *r, uint const *a, uint const *b, size_t count, size_t chunks, uint *borrow)
+		{
+			__m512i const ones = _mm512_set1_epi32(-1);
+			__m512i const zero = _mm512_setzero_si512();
+			size_t done = count / 16 * 16;
+			std::vector<__mmask16> borrows(done / 16, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 16) {
+					size_t k = i * count + j;
+					__mmask16 c = borrows[j / 16];
+					__m512i x = _mm512_loadu_si512(a + k);
+					__m512i y = _mm512_loadu_si512(b + k);
+					__m512i d = _mm512_sub_epi32(x, y);
+					__mmask16 wrapped = _mm512_cmplt_epu32_mask(x, y);
+					__mmask16 borrowed = _mm512_mask_cmpeq_epi32_mask(c, d, zero);
+					_mm512_storeu_si512(r + k, _mm512_mask_add_epi32(d, c, d, ones));
+					borrows[j / 16] = (__mmask16)(wrapped | borrowed);
+				}
+			}
+			for (size_t j = 0; borrow != nullptr && j != done; j += 16) {
+				_mm512_storeu_si512(borrow + j, _mm512_maskz_set1_epi32(borrows[j / 16], 1));
+			}
+			return done;
+		}
+
+		SIMD_TARGET("avx512f")
+		size_t mul_1_avx512(uint *r, uint const *a, uint m, size_t count, size_t chunks, uint *carry)
+		{
+			__m512i const mv = _mm512_set1_epi32((int)m);
+			// the unmasked forms of mul_epu32, srli_epi64 and slli_epi64 pass an undefined
+			// source to the builtins, which GCC 12 reports as maybe-uninitialized; with all
+			// 8 lanes selected the zero-masked forms compile to the same instructions
+			__mmask8 const all = 0xFF;
+			size_t done = count / 16 * 16;
+			std::vector<uint> carries(done, 0);
+			for (size_t i = 0; i != chunks; ++i) {
+				for (size_t j = 0; j != done; j += 16) {
+					size_t k = i * count + j;
+					__m512i c = _mm512_loadu_si512(carries.data() + j);
+					__m512i x = _mm512_loadu_si512(a + k);
+					__m512i even = _mm512_add_epi64(_mm512_maskz_mul_epu32(all, x, mv), _mm512_maskz_mov_epi32(0x5555, c));
+					__m512i odd = _mm512_add_epi64(_mm512_maskz_mul_epu32(all, _mm512_maskz_srli_epi64(all, x, 32), mv),
+						_mm512_maskz_srli_epi64(all, c, 32));
+					_mm512_storeu_si512(r + k, _mm512_mask_blend_epi32(0xAAAA, even, _mm512_maskz_slli_epi64(all, odd, 32)));
+					_mm512_storeu_si512(carries.data() + j,
+						_mm512_mask_blend_epi32(0xAAAA, _mm512_maskz_srli_epi64(all, even, 32), odd));
+				}
+			}
+			if (carry != nullptr) {
+				std::copy(carries.begin(), carries.end(), carry);
+			}
+			return done;
+		}
+
+		SIMD_TARGET("avx512f")
+		size_t cmp_avx512(int *res, uint const *a, uint const *b, size_t count, size_t chunks)
+		{
+			__m512i const one = _mm512_set1_epi32(1);
+			__m512i const minus_one = _mm512_set1_epi32(-1);
+			size_t done = count / 16 * 16;
+			std::vector<__mmask16> decided(done / 16, 0);
+			for (size_t i = chunks; i-- != 0;) {
+				__mmask16 all = 0xFFFF;
+				for (size_t j = 0; j != done; j += 16) {
+					size_t k = i * count + j;
+					__m512i x = _mm512_loadu_si512(a + k);
+					__m512i y = _mm512_loadu_si512(b + k);
+					__mmask16 open = (__mmask16)~decided[j / 16];
+					__mmask16 gt = _mm512_mask_cmpgt_epu32_mask(open, x, y);
+					__mmask16 lt = _mm512_mask_cmplt_epu32_mask(open, x, y);
+					__m512i r = (i + 1 == chunks) ? _mm512_setzero_si512() : _mm512_loadu_si512(res + j);
+					r = _mm512_mask_mov_epi32(r, gt, one);
+					r = _mm512_mask_mov_epi32(r, lt, minus_one);
+					_mm512_storeu_si512(res + j, r);
+					decided[j / 16] = (__mmask16)(decided[j / 16] | gt | lt);
+					all = (__mmask16)(all & decided[j / 16]);
+				}
+				if (all == 0xFFFF) {
+					break;
+				}
+			}
+			if (chunks == 0) {
+				std::fill(res, res + done, 0);
+			}
+			return done;
+		}
+#endif
+
+		kernel widest_supported()
+		{
+			if (cpu::has_avx512f()) {
+				return kernel::avx512;
+			}
+			if (cpu::has_avx2()) {
+				return kernel::avx2;
+			}
+			return kernel::scalar;
+		}
+
+		// -1 until the first call picks the widest supported kernel
+		std::atomic<int> current(-1);
+
+		void check(big_integer_batch const &a, big_integer_batch const &b)
+		{
+			if (a.size() != b.size() || a.chunks() != b.chunks()) {
+				throw std::runtime_error("batch sizes differ");
+			}
+		}
+	}
+
+	char const *name(kernel k)
+	{
+		switch (k) {
+		case kernel::avx2:
+			return "avx2";
+		case kernel::avx512:
+			return "avx512";
+		default:
+			return "scalar";
+		}
+	}
+
+	kernel active()
+	{
+		int k = current.load(std::memory_order_relaxed);
+		if (k < 0) {
+			k = static_cast<int>(widest_supported());
+			current.store(k, std::memory_order_relaxed);
+		}
+		return static_cast<kernel>(k);
+	}
+
+	kernel select(kernel k)
+	{
+		if (k == kernel::avx512 && !cpu::has_avx512f()) {
+			k = kernel::avx2;
+		}
+		if (k == kernel::avx2 && !cpu::has_avx2()) {
+			k = kernel::scalar;
+		}
+		current.store(static_cast<int>(k), std::memory_order_relaxed);
+		return k;
+	}
+
+	void add(big_integer_batch &r, big_integer_batch const &a, big_integer_batch const &b, uint *carry)
+	{
+		check(r, a);
+		check(a, b);
+		size_t done = 0;
+#ifdef HAVE_X86_SIMD
+		switch (active()) {
+		case kernel::avx512:
+			done = add_avx512(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), carry);
+			break;
+		case kernel::avx2:
+			done = add_avx2(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), carry);
+			break;
+		default:
+			break;
+		}
+#endif
+		add_scalar(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), carry, done);
+	}
+
+	void sub(big_integer_batch &r, big_integer_batch const &a, big_integer_batch const &b, uint *borrow)
+	{
+		check(r, a);
+		check(a, b);
+		size_t done = 0;
+#ifdef HAVE_X86_SIMD
+		switch (active()) {
+		case kernel::avx512:
+			done = sub_avx512(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), borrow);
+			break;
+		case kernel::avx2:
+			done = sub_avx2(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), borrow);
+			break;
+		default:
+			break;
+		}
+#endif
+		sub_scalar(r.chunk(0), a.chunk(0), b.chunk(0), a.size(), a.chunks(), borrow, done);
+	}
+
+	void mul_1(big_integer_batch &r, big_integer_batch const &a, uint m, uint *carry)
+	{
+		check(r, a);
+		size_t done = 0;
+#ifdef HAVE_X86_SIMD
+		switch (active()) {
+		case kernel::avx512:
+			done = mul_1_avx512(r.chunk(0), a.chunk(0), m, a.size(), a.chunks(), carry);
+			break;
+		case kernel::avx2:
+			done = mul_1_avx2(r.chunk(0), a.chunk(0), m, a.size(), a.chunks(), carry);
+			break;
+		default:
+			break;
+		}
+#endif
+		mul_1_scalar(r.chunk(0), a.chunk(0), m, a.size(), a.chunks(), carry, done);
+	}
+
+	void cmp(int *res, big_integer_batch const &a, big_integer_batch const &b)
+	{
+		check(a, b);
+		size_t done = 0;
+#ifdef HAVE_X86_SIMD
+		switch (active()) {
+		case kernel::avx512:
+			done = cmp_avx512(res, a.chunk(0), b.chunk(0), a.size(), a.chunks());
+			break;
+		case kernel::avx2:
+			done = cmp_avx2(res, a.chunk(0), b.chunk(0), a.size(), a.chunks());
+			break;
+		default:
+			break;
+		}
+#endif
+		cmp_scalar(res, a.chunk(0), b.chunk(0), a.size(), a.chunks(), done);
+	}
+}
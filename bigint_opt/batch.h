@@ -0,0 +1,71 @@
+#ifndef BIG_INTEGER_BATCH_H
+#define BIG_INTEGER_BATCH_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Many unsigned numbers of the same width, stored as structure of arrays:
+// chunk i of every element is contiguous, so one vector instruction works on
+// the same chunk of 8 (AVX2) or 16 (AVX-512) elements. Values wrap around
+// modulo 2^(32 * chunks), as in fixed_big_integer.
+class big_integer_batch {
+public:
+	using uint = std::uint32_t;
+
+	// count elements of chunks chunks each, all zero
+	big_integer_batch(size_t count, size_t chunks);
+
+	size_t size() const {
+		return count;
+	}
+
+	size_t chunks() const {
+		return width;
+	}
+
+	// chunk i of every element, size() entries
+	uint *chunk(size_t i) {
+		return data.data() + i * count;
+	}
+
+	uint const *chunk(size_t i) const {
+		return data.data() + i * count;
+	}
+
+	// element j; negative values are stored in two's complement
+	void set(size_t j, big_integer const &value);
+	big_integer get(size_t j) const;
+
+private:
+	size_t count;
+	size_t width;
+	std::vector<uint> data;
+};
+
+// Elementwise operations on batches of the same size() and chunks(); the result
+// may be one of the operands. Each call runs the widest kernel the CPU supports.
+namespace batch {
+	using uint = std::uint32_t;
+
+	enum class kernel { scalar, avx2, avx512 };
+
+	char const *name(kernel k);
+	// the kernel in use
+	kernel active();
+	// uses k, or the widest supported kernel below it; returns the kernel now in use
+	kernel select(kernel k);
+
+	// r = a + b; carry[j], if given, receives the carry out of element j
+	void add(big_integer_batch &r, big_integer_batch const &a, big_integer_batch const &b, uint *carry = nullptr);
+	// r = a - b; borrow[j], if given, receives the borrow out of element j
+	void sub(big_integer_batch &r, big_integer_batch const &a, big_integer_batch const &b, uint *borrow = nullptr);
+	// r = a * m; carry[j], if given, receives the chunk carried out of element j
+	void mul_1(big_integer_batch &r, big_integer_batch const &a, uint m, uint *carry = nullptr);
+	// res[j] = -1, 0 or 1 as a[j] is less than, equal to or greater than b[j]
+	void cmp(int *res, big_integer_batch const &a, big_integer_batch const &b);
+}
+
+#endif // BIG_INTEGER_BATCH_H
@@ -2,6 +2,10 @@
 
 #include "big_integer.h"
 #include "my_vector.h"
+#include "limbs.h"
+#include "parallel.h"
+#include "instrumentation.h"
+#include "tuning.h"
 
 #include <cstring>
 #include <sstream>
@@ -9,6 +13,8 @@
 #include <algorithm>
 #include <cctype>
 #include <iterator>
+#include <mutex>
+#include <vector>
 
 #include <iostream>
 
@@ -18,6 +24,9 @@ using seqset = my_vector;
 extern constexpr uint CHUNK_BIT_SIZE = sizeof(int32_t) << 3;
 extern constexpr uint64_t NUM_SYS_BASE = (uint64_t)MAX_CHUNK_NUM + 1;
 
+constexpr uint DECIMAL_CHUNK = 1000000000;
+constexpr size_t DECIMAL_CHUNK_DIGITS = 9;
+
 big_integer::big_integer()
 	: signum(0) {
 	data.clear();
@@ -42,6 +51,17 @@ big_integer::big_integer(uint a)
 	data[0] = a;
 }
 
+big_integer::big_integer(ull a)
+	: signum((a == 0) ? 0 : 1) {
+	data.clear();
+	data.resize(1);
+
+	data[0] = (uint)(a & MAX_CHUNK_NUM);
+	if (a >> CHUNK_BIT_SIZE) {
+		data.push_back((uint)(a >> CHUNK_BIT_SIZE));
+	}
+}
+
 big_integer::big_integer(big_integer const & other)
 {
 	data = other.data;
@@ -49,7 +69,13 @@ big_integer::big_integer(big_integer const & other)
 }
 
 big_integer::big_integer(std::string const &str) {
-	if (str_to_bint(str, *this) != 0) {
+	if (str_to_bint(str, *this, 1) != 0) {
+		throw std::runtime_error("invalid string");
+	}
+}
+
+big_integer::big_integer(std::string const &str, parallel::policy const &policy) {
+	if (str_to_bint(str, *this, policy.threads) != 0) {
 		throw std::runtime_error("invalid string");
 	}
 }
@@ -62,6 +88,8 @@ big_integer & big_integer::operator=(big_integer const & other)
 }
 
 big_integer &big_integer::operator+=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(add, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (rhs.is_zero()) {
 		return *this;
 	}
@@ -82,6 +110,8 @@ big_integer &big_integer::operator+=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator-=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(sub, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (rhs.is_zero()) {
 		return *this;
 	}
@@ -116,6 +146,12 @@ big_integer &big_integer::operator-=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator*=(big_integer const &rhs) {
+	return multiply(rhs, 1);
+}
+
+big_integer &big_integer::multiply(big_integer const &rhs, size_t threads) {
+	BIGINT_INSTRUMENT(mul, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (rhs.is_zero()) {
 		return *this = 0;
 	}
@@ -130,17 +166,26 @@ big_integer &big_integer::operator*=(big_integer const &rhs) {
 		return *this;
 	}
 
-	big_integer res;
-	for (size_t i = 0; i != rhs.get_data_size(); ++i) {
-		res.shifted_summation(mul_long_short(rhs.data[i]).get_data(), i);
-		remove_leading_0(res.data);
+	seqset const &lhs_data = data, &rhs_data = rhs.data;
+	seqset res_data(lhs_data.size() + rhs_data.size());
+	if (lhs_data.begin() == rhs_data.begin() && lhs_data.size() == rhs_data.size()) {
+		limbs::sqr(res_data.begin(), lhs_data.begin(), lhs_data.size(), threads);
+	}
+	else {
+		limbs::mul(res_data.begin(),
+			lhs_data.begin(), lhs_data.size(),
+			rhs_data.begin(), rhs_data.size(), threads);
 	}
+	remove_leading_0(res_data);
 
-	res.signum = signum * rhs.signum;
-	return *this = res;
+	data = res_data;
+	signum *= rhs.signum;
+	return *this;
 }
 
 big_integer &big_integer::operator/=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(div, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (rhs.is_zero()) {
 		throw std::runtime_error("division by 0");
 	}
@@ -153,63 +198,43 @@ big_integer &big_integer::operator/=(big_integer const &rhs) {
 		return *this;
 	}
 
-	int comp = compare_abs_numbers(*this, rhs);
-	if (comp == -1)
-		return *this = 0;
-	else if (comp == 0)
-		return *this = 1;
-
-	big_integer res;
-	big_integer remaind(*this), divis(rhs);
-
-	const uint k = (uint)(NUM_SYS_BASE / ((ull)divis.data.back() + 1));
-	remaind.mul_this_long_short(k); divis.mul_this_long_short(k);
-
-	remaind.data.push_back(0);
-	size_t prefix_size = divis.get_data_size() + 1, dividend_size = remaind.get_data_size();
-
-	res.data.resize(dividend_size - prefix_size + 1);
-
-	big_integer q_ch;
-	uint quotient_chunk;
-
-	size_t i = prefix_size, j = res.data.size() - 1;
-	while (i++ <= dividend_size)
-	{
-		ull two_last_chunks = ((ull)(remaind.data[remaind.get_data_size() - 1]) << CHUNK_BIT_SIZE)
-			| remaind.data[remaind.get_data_size() - 2];
-		quotient_chunk = std::min((uint)(two_last_chunks / divis.data.back()), MAX_CHUNK_NUM);
-
-		q_ch = divis.mul_long_short(quotient_chunk);
-
-		while (compare_prefix(remaind, q_ch, prefix_size) == 0) {
-			--quotient_chunk;
-			q_ch = divis.mul_long_short(quotient_chunk);
-		}
-		res.data[j] = quotient_chunk;
-		prefix_subtract(remaind, q_ch, prefix_size);
-
-		if (remaind.data.back() == 0) remaind.data.pop_back();
-		--j;
+	int res_sign = signum * rhs.signum;
+	big_integer remainder;
+	divide_abs(rhs, *this, remainder);
+	if (!is_zero()) {
+		signum = res_sign;
 	}
-	remove_leading_0(res.data);
-
-	res.signum = signum * rhs.signum;
-	return *this = res;
+	return *this;
 }
 
 big_integer &big_integer::operator%=(big_integer const &rhs) {
-	if (rhs.get_data_size() == 1) {
+	BIGINT_INSTRUMENT(mod, std::max(get_data_size(), rhs.get_data_size()));
+
+	if (rhs.is_zero()) {
+		throw std::runtime_error("division by 0");
+	}
+	else if (rhs.get_data_size() == 1) {
+		// no quotient needed
 		int res_sign = this->signum;
-		*this = div_long_short(rhs.get_chunk(0));
+		seqset const &lhs_data = data;
+		*this = limbs::mod_1(lhs_data.begin(), lhs_data.size(), limbs::divisor_1(rhs.get_chunk(0)));
 
 		this->signum *= res_sign;
 		return *this;
 	}
-	return *this -= (*this / rhs) * rhs;
+
+	int res_sign = this->signum;
+	big_integer quotient;
+	divide_abs(rhs, quotient, *this);
+	if (!is_zero()) {
+		signum = res_sign;
+	}
+	return *this;
 }
 
 big_integer &big_integer::operator&=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(bit_and, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (this->is_zero()) {
 		return *this;
 	}
@@ -226,6 +251,8 @@ big_integer &big_integer::operator&=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator|=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(bit_or, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (this->is_zero()) {
 		return *this = rhs;
 	}
@@ -242,6 +269,8 @@ big_integer &big_integer::operator|=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator^=(big_integer const &rhs) {
+	BIGINT_INSTRUMENT(bit_xor, std::max(get_data_size(), rhs.get_data_size()));
+
 	if (this->is_zero()) {
 		return *this = rhs;
 	}
@@ -258,6 +287,8 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator<<=(int shift) {
+	BIGINT_INSTRUMENT(shl, get_data_size());
+
 	if (this->is_zero()) {
 		return *this;
 	}
@@ -288,6 +319,8 @@ big_integer &big_integer::operator<<=(int shift) {
 }
 
 big_integer &big_integer::operator>>=(int shift) {
+	BIGINT_INSTRUMENT(shr, get_data_size());
+
 	if (this->is_zero()) {
 		return *this;
 	}
@@ -295,16 +328,20 @@ big_integer &big_integer::operator>>=(int shift) {
 		return *this <<= -shift;
 	}
 
-	seqset copy_this;
-	copy_this = (signum == 1)
-		? copy_this = this->data
-		: copy_this = this->convert_to_2c().get_data();
+	else if (signum < 0) {
+		// rounds towards -inf: -((|a| - 1) >> shift) - 1
+		negate();
+		--*this;
+		*this >>= shift;
+		++*this;
+		return negate();
+	}
+
+	seqset copy_this(this->data);
 
 	ull shift_in = shift % CHUNK_BIT_SIZE;
 	size_t shift_out = shift / CHUNK_BIT_SIZE;
-	seqset tmp(copy_this.size(), (signum == 1)
-		? 0
-		: (MAX_CHUNK_NUM << (CHUNK_BIT_SIZE - shift_in)));
+	seqset tmp(copy_this.size(), 0);
 
 	ull cur = 0;
 	size_t i = copy_this.size();
@@ -320,9 +357,102 @@ big_integer &big_integer::operator>>=(int shift) {
 	if (get_data_size() == 1 && get_chunk(0) == 0)
 		this->signum = 0;
 
-	return (signum < 0)
-		? *this = this->convert_to_2c()
-		: *this;
+	return *this;
+}
+
+size_t big_integer::bit_length() const
+{
+	if (is_zero()) {
+		return 0;
+	}
+	size_t top = data.size() - 1;
+	return (top + 1) * CHUNK_BIT_SIZE - limbs::count_leading_zeros(data[top]);
+}
+
+size_t big_integer::popcount() const
+{
+	size_t res = 0;
+	for (uint chunk : data) {
+		res += limbs::popcount(chunk);
+	}
+	return res;
+}
+
+size_t big_integer::ctz() const
+{
+	if (is_zero()) {
+		return 0;
+	}
+	size_t i = 0;
+	while (data[i] == 0) {
+		++i;
+	}
+	return i * CHUNK_BIT_SIZE + limbs::count_trailing_zeros(data[i]);
+}
+
+bool big_integer::test_bit(size_t bit) const
+{
+	size_t index = bit / CHUNK_BIT_SIZE;
+	bool magnitude_bit = index < data.size() && ((data[index] >> (bit % CHUNK_BIT_SIZE)) & 1);
+	if (signum >= 0) {
+		return magnitude_bit;
+	}
+
+	// -m = ~(m - 1): bits below the lowest set bit of m stay 0, the rest are inverted
+	size_t low = ctz();
+	return (bit <= low) ? (bit == low) : !magnitude_bit;
+}
+
+big_integer big_integer::single_bit(size_t bit)
+{
+	big_integer res;
+	res.data.resize(bit / CHUNK_BIT_SIZE + 1);
+	res.data[bit / CHUNK_BIT_SIZE] = (uint)1 << (bit % CHUNK_BIT_SIZE);
+	res.signum = 1;
+	return res;
+}
+
+big_integer &big_integer::set_bit(size_t bit) {
+	if (signum < 0) {
+		return *this |= single_bit(bit);
+	}
+
+	size_t index = bit / CHUNK_BIT_SIZE;
+	if (index >= data.size()) {
+		data.resize(index + 1);
+	}
+	data[index] |= (uint)1 << (bit % CHUNK_BIT_SIZE);
+	signum = 1;
+	return *this;
+}
+
+big_integer &big_integer::clear_bit(size_t bit) {
+	if (signum < 0) {
+		return *this &= ~single_bit(bit);
+	}
+
+	size_t index = bit / CHUNK_BIT_SIZE;
+	if (index < data.size()) {
+		data[index] &= ~((uint)1 << (bit % CHUNK_BIT_SIZE));
+		remove_leading_0(data);
+		signum = (data.size() == 1 && data[0] == 0) ? 0 : 1;
+	}
+	return *this;
+}
+
+big_integer &big_integer::flip_bit(size_t bit) {
+	if (signum < 0) {
+		return *this ^= single_bit(bit);
+	}
+
+	size_t index = bit / CHUNK_BIT_SIZE;
+	if (index >= data.size()) {
+		data.resize(index + 1);
+	}
+	data[index] ^= (uint)1 << (bit % CHUNK_BIT_SIZE);
+	remove_leading_0(data);
+	signum = (data.size() == 1 && data[0] == 0) ? 0 : 1;
+	return *this;
 }
 
 big_integer big_integer::operator+() const {
@@ -375,6 +505,20 @@ uint big_integer::get_chunk(size_t i) const
 	return data[i];
 }
 
+big_integer big_integer::get_chunks(size_t from, size_t to) const
+{
+	to = std::min(to, data.size());
+	big_integer res;
+	if (from >= to) {
+		return res;
+	}
+	res.data = seqset(to - from);
+	std::copy(data.begin() + from, data.begin() + to, res.data.begin());
+	res.remove_leading_0(res.data);
+	res.signum = (res.data.size() == 1 && res.data[0] == 0) ? 0 : 1;
+	return res;
+}
+
 big_integer operator+(big_integer a, big_integer const &b) { return a += b; }
 
 big_integer operator-(big_integer a, big_integer const &b) { return a -= b; }
@@ -395,6 +539,184 @@ big_integer operator<<(big_integer a, int b) { return a <<= b; }
 
 big_integer operator>>(big_integer a, int b) { return a >>= b; }
 
+static size_t window_size(size_t exp_bits)
+{
+	return (exp_bits <= 8) ? 1
+		: (exp_bits <= 24) ? 2
+		: (exp_bits <= 80) ? 3
+		: (exp_bits <= 240) ? 4
+		: 5;
+}
+
+big_integer mul(big_integer const &a, big_integer const &b, parallel::policy const &policy)
+{
+	big_integer res = a;
+	return res.multiply(b, policy.threads);
+}
+
+big_integer pow(big_integer const &base, uint64_t exp)
+{
+	BIGINT_INSTRUMENT(pow, base.get_data_size());
+
+	if (exp == 0) {
+		return 1;
+	}
+	else if (base.signum == 0 || exp == 1) {
+		return base;
+	}
+
+	// a power of two is a single shift
+	if (base.popcount() == 1) {
+		uint64_t bit = base.ctz();
+		if (bit != 0 && exp > (uint64_t)INT32_MAX / bit) {
+			throw std::runtime_error("power is too large");
+		}
+		big_integer res = big_integer(1) << (int)(bit * exp);
+		return (base.signum < 0 && (exp & 1)) ? -res : res;
+	}
+
+	// left-to-right sliding window over the odd powers base^1, base^3, ...
+	size_t exp_bits = 64;
+	while (!((exp >> (exp_bits - 1)) & 1)) {
+		--exp_bits;
+	}
+	size_t window = window_size(exp_bits);
+
+	std::vector<big_integer> odd_powers(1, base);
+	if (window > 1) {
+		big_integer square = base * base;
+		for (size_t i = 1; i != ((size_t)1 << (window - 1)); ++i) {
+			odd_powers.push_back(odd_powers.back() * square);
+		}
+	}
+
+	big_integer res(1);
+	for (size_t i = exp_bits; i != 0;) {
+		if (!((exp >> (i - 1)) & 1)) {
+			res *= res;
+			--i;
+			continue;
+		}
+
+		size_t low = (i > window) ? i - window : 0;
+		while (!((exp >> low) & 1)) {
+			++low;
+		}
+		uint64_t value = (exp >> low) & (((uint64_t)1 << (i - low)) - 1);
+		for (size_t j = low; j != i; ++j) {
+			res *= res;
+		}
+		res *= odd_powers[(size_t)(value >> 1)];
+		i = low;
+	}
+	return res;
+}
+
+void addmul(big_integer &acc, big_integer const &a, big_integer const &b)
+{
+	BIGINT_INSTRUMENT(addmul, std::max(a.get_data_size(), b.get_data_size()));
+
+	if (a.signum * b.signum != 0) {
+		// copies share the buffers and stay valid when acc is an operand
+		big_integer const lhs(a), rhs(b);
+		acc.accumulate(lhs.data, rhs.data, a.signum * b.signum);
+	}
+}
+
+void submul(big_integer &acc, big_integer const &a, big_integer const &b)
+{
+	BIGINT_INSTRUMENT(addmul, std::max(a.get_data_size(), b.get_data_size()));
+
+	if (a.signum * b.signum != 0) {
+		big_integer const lhs(a), rhs(b);
+		acc.accumulate(lhs.data, rhs.data, -a.signum * b.signum);
+	}
+}
+
+void addmul_ui(big_integer &acc, big_integer const &a, uint64_t b)
+{
+	BIGINT_INSTRUMENT(addmul, a.get_data_size());
+
+	if (a.signum != 0 && b != 0) {
+		seqset b_data((b >> CHUNK_BIT_SIZE) ? 2 : 1);
+		b_data[0] = (uint)b;
+		if (b_data.size() == 2) {
+			b_data[1] = (uint)(b >> CHUNK_BIT_SIZE);
+		}
+		big_integer const lhs(a);
+		acc.accumulate(lhs.data, b_data, a.signum);
+	}
+}
+
+// x >> zeros as n chunks at ptr, zeros below the bit length of x; bits shifted
+// out are lost; buffer holds the shifted chunks unless whole chunks are dropped
+static void drop_trailing_zeros(seqset const &x, size_t zeros, std::vector<uint> &buffer, uint const *&ptr, size_t &n)
+{
+	size_t skip = zeros / CHUNK_BIT_SIZE;
+	unsigned bits = zeros % CHUNK_BIT_SIZE;
+	ptr = x.begin() + skip;
+	n = x.size() - skip;
+	if (bits != 0) {
+		buffer.resize(n);
+		limbs::rshift(buffer.data(), ptr, n, bits);
+		ptr = buffer.data();
+		n = limbs::normalized_size(ptr, n);
+	}
+}
+
+big_integer divexact(big_integer const &a, big_integer const &b)
+{
+	BIGINT_INSTRUMENT(div, std::max(a.get_data_size(), b.get_data_size()));
+
+	if (b.is_zero()) {
+		throw std::runtime_error("division by 0");
+	}
+	else if (compare_abs_numbers(a, b) < 0) {
+		// 0 is the only multiple of b below it
+		return 0;
+	}
+
+	// Hensel division needs an odd divisor: both lose b's trailing zero bits,
+	// which a has as well when b divides it
+	size_t zeros = b.ctz();
+	std::vector<uint> a_buffer, b_buffer;
+	uint const *a_ptr, *b_ptr;
+	size_t an, bn;
+	drop_trailing_zeros(a.data, zeros, a_buffer, a_ptr, an);
+	drop_trailing_zeros(b.data, zeros, b_buffer, b_ptr, bn);
+
+	seqset q(an - bn + 1);
+	limbs::divexact(q.begin(), a_ptr, an, b_ptr, bn);
+
+	big_integer res;
+	res.assign_magnitude(q);
+	res.signum *= a.signum * b.signum;
+	return res;
+}
+
+bool divisible_by(big_integer const &a, big_integer const &b)
+{
+	BIGINT_INSTRUMENT(mod, std::max(a.get_data_size(), b.get_data_size()));
+
+	if (a.is_zero() || b.is_zero()) {
+		return a.is_zero();
+	}
+	else if (compare_abs_numbers(a, b) < 0) {
+		return false;
+	}
+
+	size_t zeros = b.ctz();
+	if (a.ctz() < zeros) {
+		return false;
+	}
+	std::vector<uint> a_buffer, b_buffer;
+	uint const *a_ptr, *b_ptr;
+	size_t an, bn;
+	drop_trailing_zeros(a.data, zeros, a_buffer, a_ptr, an);
+	drop_trailing_zeros(b.data, zeros, b_buffer, b_ptr, bn);
+	return limbs::divisible(a_ptr, an, b_ptr, bn);
+}
+
 bool operator==(big_integer const &first, big_integer const &second) {
 	return (first.signum == second.signum) && (compare_abs_numbers(first, second) == 0);
 }
@@ -427,34 +749,17 @@ bool operator>=(big_integer const &a, big_integer const &b) {
 
 std::string to_string(big_integer const &number)
 {
-	return to_string(number, '\0');
+	return big_integer::decimal_string(number, '\0', 1);
 }
 
 std::string to_string(big_integer const & number, char separator)
 {
-	string result = "";
-	size_t sep_cnt = 0;
-	big_integer copy_number(number);
-
-	while (!copy_number.is_zero()) {
-		result.push_back((char)copy_number.div_long_short(10) + '0');
-
-		if (separator != '\0' && ++sep_cnt % 3 == 0) {
-			result.push_back(separator);
-			sep_cnt = 0;
-		}
-	}
-	if (separator != '\0' && result.back() == separator)
-		result.pop_back();
+	return big_integer::decimal_string(number, separator, 1);
+}
 
-	if (number.signum == -1) {
-		result.push_back('-');
-	}
-	std::reverse(result.begin(), result.end());
-	if (result.empty()) {
-		result = "0";
-	}
-	return result;
+std::string to_string(big_integer const &number, parallel::policy const &policy)
+{
+	return big_integer::decimal_string(number, '\0', policy.threads);
 }
 
 big_integer::uint big_integer::absolute(int a)
@@ -512,16 +817,7 @@ big_integer big_integer::mul_long_short(uint val) const {
 
 uint big_integer::div_long_short(uint value)
 {
-	const uint base_mod_val = (uint)(NUM_SYS_BASE % value);
-	uint modulo = 0;
-	ull carry = 0, tmp = 0;
-	for (size_t i = data.size(); i--;)
-	{
-		modulo = (uint)((ull)modulo * base_mod_val + (ull)data[i]) % value;
-		tmp = carry * NUM_SYS_BASE + (ull)data[i];
-		data[i] = (uint)(tmp / value);
-		carry = tmp % value;
-	}
+	uint modulo = limbs::divrem_1(data.begin(), data.begin(), data.size(), limbs::divisor_1(value));
 	remove_leading_0(data);
 	if (data.back() == 0) signum = 0;
 	return modulo;
@@ -531,24 +827,67 @@ void big_integer::shifted_summation(seqset const &second, size_t shift) {
 	if (second.size() == 1 && second[0] == 0)
 		return;
 
-	ull carry = 0;
-	seqset copy_second(second);
+	// a shared handle keeps second intact if it is data itself
+	seqset const addend(second);
+	size_t len = std::max(data.size(), addend.size() + shift);
+	data.resize(len);
+
+	uint *res = data.begin();
+	uint carry = limbs::add(res + shift, res + shift, len - shift, addend.begin(), addend.size());
+	if (carry != 0) {
+		data.push_back(carry);
+	}
+}
 
-	size_t max_size = std::max((*this).data.size(), copy_second.size());
-	(*this).data.resize(max_size + shift, 0);
-	if (copy_second.size() < max_size) {
-		copy_second.resize(max_size, 0);
+void big_integer::accumulate(seqset const &a, seqset const &b, int sign)
+{
+	uint const *a_ptr = a.begin(), *b_ptr = b.begin();
+	size_t an = a.size(), bn = b.size();
+	if (an < bn) {
+		std::swap(a_ptr, b_ptr);
+		std::swap(an, bn);
 	}
 
-	for (size_t i = 0; i != max_size; ++i) {
-		carry += (ull)(*this).data[i + shift] + (ull)copy_second[i];
-		(*this).data[i + shift] = (uint)(carry & MAX_CHUNK_NUM);
-		carry >>= CHUNK_BIT_SIZE;
+	int res_sign = is_zero() ? sign : signum;
+	bool subtract = (sign != res_sign);
+
+	// one spare chunk: the carry out, or the sign of a two's complement difference
+	size_t len = std::max(data.size(), an + bn) + 1;
+	if (len > data.capacity()) {
+		data.reserve(2 * len);
 	}
-	if (carry != 0) {
-		(*this).data.push_back((uint)(carry & MAX_CHUNK_NUM));
-		carry >>= CHUNK_BIT_SIZE;
+	data.resize(len);
+	uint *res = data.begin();
+
+	if (bn < KARATSUBA_MUL_THRESHOLD) {
+		for (size_t i = 0; i != bn; ++i) {
+			if (subtract) {
+				uint borrow = limbs::submul_1(res + i, a_ptr, an, b_ptr[i]);
+				limbs::sub_1(res + i + an, res + i + an, len - i - an, borrow);
+			}
+			else {
+				uint carry = limbs::addmul_1(res + i, a_ptr, an, b_ptr[i]);
+				limbs::add_1(res + i + an, res + i + an, len - i - an, carry);
+			}
+		}
+	}
+	else {
+		std::vector<uint> product(an + bn);
+		limbs::mul(product.data(), a_ptr, an, b_ptr, bn);
+		if (subtract) {
+			limbs::sub(res, res, len, product.data(), an + bn);
+		}
+		else {
+			limbs::add(res, res, len, product.data(), an + bn);
+		}
+	}
+
+	if (subtract && (res[len - 1] >> (CHUNK_BIT_SIZE - 1)) != 0) {
+		negate_twos_complement(data);
+		res_sign = -res_sign;
 	}
+	remove_leading_0(data);
+	signum = (data.size() == 1 && data[0] == 0) ? 0 : res_sign;
 }
 
 big_integer big_integer::seqset_subtract(big_integer const &lhs, big_integer const &rhs)
@@ -558,7 +897,7 @@ big_integer big_integer::seqset_subtract(big_integer const &lhs, big_integer con
 
 	ull carry = 0;
 	for (size_t i = 0; i != rhs.get_data_size(); ++i) {
-		if (rhs.get_chunk(i) <= (ll)lhs.get_chunk(i) - carry) {
+		if ((ll)rhs.get_chunk(i) <= (ll)lhs.get_chunk(i) - (ll)carry) {
 			res_data[i] = (uint)((ull)lhs.get_chunk(i) - carry - rhs.get_chunk(i));
 			carry = 0;
 		}
@@ -569,7 +908,7 @@ big_integer big_integer::seqset_subtract(big_integer const &lhs, big_integer con
 	}
 	for (size_t i = rhs.get_data_size(); i != max_size; ++i) {
 		res_data[i] = (uint)(lhs.data[i] - carry);
-		carry = 0;
+		carry = (carry != 0 && lhs.data[i] == 0) ? 1 : 0;
 	}
 
 	remove_leading_0(res_data);
@@ -580,64 +919,317 @@ big_integer big_integer::seqset_subtract(big_integer const &lhs, big_integer con
 	return res;
 }
 
-void big_integer::prefix_subtract(big_integer &first, big_integer const &second, size_t const prefix_size) {
-	size_t postfix_shift = first.get_data_size() - prefix_size;
-	uint sec_chunk, tmp;
-	int borrow = 0;
-	for (size_t i = 0; i != prefix_size; ++i) {
-		sec_chunk = (i < second.get_data_size())
-			? second.data[i]
-			: 0;
-		tmp = first.data[i + postfix_shift] - sec_chunk - borrow;
-		borrow = (int)((sec_chunk + borrow) > first.data[i + postfix_shift]);
-		first.data[i + postfix_shift] = tmp;
-	}
-}
-
-int big_integer::compare_prefix(big_integer const &first, big_integer const &second, size_t const pref_size) {
-	int start = (int)(first.get_data_size() - pref_size);
-
-	uint sec_chunk;
-	for (int i = (int)first.get_data_size() - 1, j = (int)(pref_size - 1); i >= start; --i, --j) {
-		sec_chunk = (j < (int)second.get_data_size())
-			? second.data[j]
-			: 0;
-		if (first.data[i] != sec_chunk) {
-			return (first.data[i] > sec_chunk)
-				? 1
-				: 0;
-		}
+void big_integer::divide_abs(big_integer const &rhs, big_integer &quotient, big_integer &remainder) const
+{
+	if (compare_abs_numbers(*this, rhs) < 0) {
+		remainder.assign_magnitude(data);
+		quotient = 0;
+		return;
 	}
-	return 1;
+
+	seqset const &lhs_data = data, &rhs_data = rhs.data;
+	seqset q(lhs_data.size() - rhs_data.size() + 1), r(rhs_data.size());
+	limbs::divrem(q.begin(), r.begin(),
+		lhs_data.begin(), lhs_data.size(),
+		rhs_data.begin(), rhs_data.size());
+
+	quotient.assign_magnitude(q);
+	remainder.assign_magnitude(r);
+}
+
+void big_integer::assign_magnitude(seqset value)
+{
+	remove_leading_0(value);
+	data = value;
+	signum = (data.size() == 1 && data[0] == 0) ? 0 : 1;
 }
 
-int big_integer::str_to_bint(const string &str, big_integer &number) {
+int big_integer::str_to_bint(const string &str, big_integer &number, size_t threads) {
+	// about 9.63 decimal digits per chunk
+	BIGINT_INSTRUMENT(parse, str.size() * 10 / 96 + 1);
+
 	if (str.empty()) {
 		throw std::runtime_error("empty string");
 	}
-	number.signum = 0;
 
-	size_t i = 0;
-	if (str[i] == '-' || str[i] == '+') {
-		++i;
-	}
-	for (; i != str.size(); ++i) {
+	size_t first_digit = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+	for (size_t i = first_digit; i != str.size(); ++i) {
 		if (!std::isdigit(str[i])) {
-			throw std::runtime_error("invalid character: " + str[i]);
+			throw std::runtime_error(std::string("invalid character: ") + str[i]);
 		}
-		number.mul_this_long_short(10);
-		number += (int)(str[i] - '0');
 	}
 
-	if (number.get_data_size() != 0) {
-		number.signum = (str[0] == '-') ? -1 : 1;
+	number = read_decimal(str, first_digit, str.size(), threads);
+	if (str[0] == '-') {
+		number.negate();
+	}
+	return 0;
+}
+
+big_integer big_integer::decimal_power(size_t level)
+{
+	// grown on demand; parallel conversions read it from several threads
+	static std::mutex lock;
+	static std::vector<big_integer> powers;
+	std::lock_guard<std::mutex> guard(lock);
+	while (powers.size() <= level) {
+		powers.push_back(powers.empty()
+			? big_integer(DECIMAL_CHUNK)
+			: powers.back() * powers.back());
+	}
+	return powers[level];
+}
+
+std::string big_integer::decimal_string(big_integer const &number, char separator, size_t threads)
+{
+	BIGINT_INSTRUMENT(to_string, number.get_data_size());
+
+	if (number.is_zero()) {
+		return "0";
+	}
+
+	// at most bit_length * log10(2) + 1 digits, written right-aligned over zeros
+	size_t sign = (number.signum == -1) ? 1 : 0;
+	size_t width = (size_t)((double)number.bit_length() * 0.30102999566398120) + 2;
+	string res(sign + width, '0');
+	write_decimal(number, &res[sign], width, threads);
+	res.erase(sign, res.find_first_not_of('0', sign) - sign);
+	if (sign != 0) {
+		res[0] = '-';
+	}
+
+	if (separator == '\0') {
+		return res;
+	}
+	size_t digits = res.size() - sign;
+	string separated(res, 0, sign);
+	for (size_t i = 0; i != digits; ++i) {
+		if (i != 0 && (digits - i) % 3 == 0) {
+			separated.push_back(separator);
+		}
+		separated.push_back(res[sign + i]);
+	}
+	return separated;
+}
+
+void big_integer::write_decimal(big_integer const &number, char *out, size_t width, size_t threads)
+{
+	if (number.get_data_size() <= DC_CONVERSION_THRESHOLD) {
+		// nine digits per division, right to left; number < 10^width, so anything
+		// past the left end of the slice is zero
+		static limbs::divisor_1 const decimal_chunk(DECIMAL_CHUNK);
+		std::vector<uint> chunks(number.data.begin(), number.data.end());
+		size_t size = limbs::normalized_size(chunks.data(), chunks.size());
+		char *end = out + width;
+		while (size != 0 && end != out) {
+			uint group = limbs::divrem_1(chunks.data(), chunks.data(), size, decimal_chunk);
+			size = limbs::normalized_size(chunks.data(), size);
+			for (size_t i = 0; i != DECIMAL_CHUNK_DIGITS && end != out; ++i) {
+				*--end = (char)('0' + group % 10);
+				group /= 10;
+			}
+		}
+		return;
+	}
+
+	// split by 10^(9 * 2^level), the largest table entry not above sqrt(number)
+	// that leaves the high part at least one digit
+	size_t level = 0;
+	while (2 * decimal_power(level + 1).get_data_size() - 1 <= number.get_data_size()
+		&& (DECIMAL_CHUNK_DIGITS << (level + 1)) < width) {
+		++level;
+	}
+	size_t low_digits = DECIMAL_CHUNK_DIGITS << level;
+
+	big_integer high, low;
+	number.divide_abs(decimal_power(level), high, low);
+
+	// the halves fill disjoint slices of out
+	if (threads >= 2 && number.get_data_size() >= PARALLEL_CONVERSION_THRESHOLD) {
+		size_t share = (threads + 1) / 2;
+		parallel::task_group group;
+		group.run([&] { write_decimal(high, out, width - low_digits, share); });
+		write_decimal(low, out + width - low_digits, low_digits, threads - share);
+		group.wait();
+		return;
+	}
+	write_decimal(high, out, width - low_digits, 1);
+	write_decimal(low, out + width - low_digits, low_digits, 1);
+}
+
+big_integer big_integer::read_decimal(std::string const &str, size_t from, size_t to, size_t threads)
+{
+	size_t len = to - from;
+	if (len <= DECIMAL_CHUNK_DIGITS * DC_CONVERSION_THRESHOLD) {
+		seqset res_data(len / DECIMAL_CHUNK_DIGITS + 2);
+		uint *res = res_data.begin();
+		size_t res_size = 0;
+
+		size_t group = len % DECIMAL_CHUNK_DIGITS;
+		if (group == 0) {
+			group = DECIMAL_CHUNK_DIGITS;
+		}
+		for (size_t i = from; i < to; i += group, group = DECIMAL_CHUNK_DIGITS) {
+			uint value = 0, scale = 1;
+			for (size_t j = i; j != i + group; ++j) {
+				value = value * 10 + (uint)(str[j] - '0');
+				scale *= 10;
+			}
+			uint carry = limbs::mul_1(res, res, res_size, scale);
+			if (carry != 0) {
+				res[res_size++] = carry;
+			}
+			ull sum = value;
+			for (size_t k = 0; sum != 0; ++k) {
+				if (k == res_size) {
+					++res_size;
+				}
+				sum += res[k];
+				res[k] = (uint)sum;
+				sum >>= CHUNK_BIT_SIZE;
+			}
+		}
+
+		big_integer number;
+		number.assign_magnitude(res_data);
+		return number;
+	}
+
+	size_t level = 0;
+	while ((DECIMAL_CHUNK_DIGITS << (level + 1)) < len) {
+		++level;
+	}
+	size_t split = to - (DECIMAL_CHUNK_DIGITS << level);
+
+	big_integer high, low;
+	if (threads >= 2 && len >= DECIMAL_CHUNK_DIGITS * PARALLEL_CONVERSION_THRESHOLD) {
+		size_t share = (threads + 1) / 2;
+		parallel::task_group group;
+		group.run([&] { high = read_decimal(str, from, split, share); });
+		low = read_decimal(str, split, to, threads - share);
+		group.wait();
 	}
 	else {
-		number.data.push_back(0);
+		high = read_decimal(str, from, split, 1);
+		low = read_decimal(str, split, to, 1);
 	}
+	high.multiply(decimal_power(level), threads);
+	return high += low;
+}
 
-	remove_leading_0(number.data);
-	return 0;
+big_integer big_integer::read_decimal(std::streambuf &buf, size_t &digits)
+{
+	// As the string version, but bottom-up since the length is unknown: leaves
+	// of 9 * 2^leaf_level digits are read schoolbook, a word of digits at a
+	// time, and pushed as segments; two segments of 9 * 2^level digits merge
+	// into one of the next level, like the carries of a binary counter. Only
+	// the segments, about the size of the result, are kept.
+	size_t leaf_level = 0;
+	while (((size_t)2 << leaf_level) <= DC_CONVERSION_THRESHOLD) {
+		++leaf_level;
+	}
+	size_t const leaf_digits = DECIMAL_CHUNK_DIGITS << leaf_level;
+	// 10^19 < 2^64
+	size_t const block_digits = 19;
+
+	std::vector<std::pair<big_integer, size_t>> segments;
+	seqset leaf_data(leaf_digits / DECIMAL_CHUNK_DIGITS + 2);
+	uint *leaf = leaf_data.begin();
+	size_t leaf_size = 0, leaf_rest = leaf_digits;
+
+	digits = 0;
+	int c = buf.sgetc();
+	while (c >= '0' && c <= '9') {
+		ull block = 0, scale = 1;
+		size_t count = 0;
+		for (; count != std::min(block_digits, leaf_rest) && c >= '0' && c <= '9'; ++count) {
+			block = block * 10 + (ull)(c - '0');
+			scale *= 10;
+			c = buf.snextc();
+		}
+		for (ull carry = limbs::mul_2(leaf, leaf, leaf_size, scale, block); carry != 0; carry >>= CHUNK_BIT_SIZE) {
+			leaf[leaf_size++] = (uint)carry;
+		}
+		digits += count;
+		leaf_rest -= count;
+		if (leaf_rest != 0) {
+			continue;
+		}
+
+		big_integer segment;
+		segment.assign_magnitude(leaf_data);
+		segments.emplace_back(segment, leaf_level);
+		while (segments.size() >= 2 && segments[segments.size() - 2].second == segments.back().second) {
+			size_t level = segments.back().second;
+			big_integer low = segments.back().first;
+			segments.pop_back();
+			big_integer &high = segments.back().first;
+			high.multiply(decimal_power(level), 1);
+			high += low;
+			segments.back().second = level + 1;
+		}
+		leaf_data = seqset(leaf_digits / DECIMAL_CHUNK_DIGITS + 2);
+		leaf = leaf_data.begin();
+		leaf_size = 0;
+		leaf_rest = leaf_digits;
+	}
+
+	// the partial leaf is the lowest part, the segments follow from the top of the stack
+	big_integer res;
+	res.assign_magnitude(leaf_data);
+	big_integer scale = pow(big_integer(10), leaf_digits - leaf_rest);
+	for (size_t i = segments.size(); i-- != 0;) {
+		big_integer &segment = segments[i].first;
+		segment.multiply(scale, 1);
+		res += segment;
+		if (i != 0) {
+			scale.multiply(decimal_power(segments[i].second), 1);
+		}
+	}
+	return res;
+}
+
+big_integer big_integer::read_power_of_two(std::streambuf &buf, unsigned bits, size_t &digits)
+{
+	// whole chunks go in as they come, most significant first; the digits after
+	// the last whole chunk are shifted in once the end is known
+	size_t const chunk_digits = CHUNK_BIT_SIZE / bits;
+	seqset res_data;
+	uint value = 0;
+	size_t count = 0;
+
+	digits = 0;
+	for (int c = buf.sgetc();; c = buf.snextc()) {
+		int digit = (c >= '0' && c <= '9') ? c - '0'
+			: (c >= 'a' && c <= 'f') ? c - 'a' + 10
+			: (c >= 'A' && c <= 'F') ? c - 'A' + 10
+			: -1;
+		if (digit < 0 || (digit >> bits) != 0) {
+			break;
+		}
+		value = (value << bits) | (uint)digit;
+		++digits;
+		if (++count == chunk_digits) {
+			res_data.push_back(value);
+			value = 0;
+			count = 0;
+		}
+	}
+
+	res_data.reverse();
+	if (res_data.empty()) {
+		res_data.push_back(value);
+	}
+	else if (count != 0) {
+		uint *res = res_data.begin();
+		uint top = limbs::lshift(res, res, res_data.size(), (unsigned)(count * bits));
+		res[0] |= value;
+		res_data.push_back(top);
+	}
+
+	big_integer number;
+	number.assign_magnitude(res_data);
+	return number;
 }
 
 bool big_integer::is_zero() const
@@ -655,8 +1247,45 @@ big_integer big_integer::convert_to_2c() const {
 	return res;
 }
 
+seqset big_integer::twos_complement_data(size_t len) const
+{
+	seqset res(len, 0);
+	uint *out = res.begin();
+	std::copy(data.begin(), data.end(), out);
+	if (signum < 0) {
+		negate_twos_complement(res);
+	}
+	return res;
+}
+
+void big_integer::assign_twos_complement(seqset value)
+{
+	bool negative = (value.back() >> (CHUNK_BIT_SIZE - 1)) != 0;
+	if (negative) {
+		negate_twos_complement(value);
+	}
+	remove_leading_0(value);
+
+	data = value;
+	signum = (data.size() == 1 && data[0] == 0)
+		? 0
+		: (negative ? -1 : 1);
+}
+
+void big_integer::negate_twos_complement(seqset &value)
+{
+	ull carry = 1;
+	for (uint &chunk : value) {
+		carry += (uint)~chunk;
+		chunk = (uint)(carry & MAX_CHUNK_NUM);
+		carry >>= CHUNK_BIT_SIZE;
+	}
+}
+
 int compare_abs_numbers(big_integer const &first, big_integer const &second)
 {
+	BIGINT_INSTRUMENT(cmp, std::max(first.get_data_size(), second.get_data_size()));
+
 	if (first.get_data_size() == second.get_data_size()) {
 		auto mypair = std::mismatch(first.data.rbegin(), first.data.rend(), second.data.rbegin());
 		if (mypair.first == first.data.rend()) {
@@ -676,9 +1305,49 @@ std::ostream &operator<<(std::ostream &out, big_integer const &a)
 
 std::istream & operator>>(std::istream & in, big_integer &a)
 {
-	std::string tmp;
-	in >> tmp;
-	a = big_integer(tmp);
+	using traits = std::istream::traits_type;
+
+	std::istream::sentry sentry(in);
+	if (!sentry) {
+		return in;
+	}
+	std::streambuf &buf = *in.rdbuf();
+
+	int c = buf.sgetc();
+	bool negative = (c == '-');
+	if (c == '-' || c == '+') {
+		c = buf.snextc();
+	}
+
+	size_t digits = 0;
+	big_integer res;
+	if (c == '0') {
+		c = buf.snextc();
+		unsigned bits = (c == 'x' || c == 'X') ? 4 : (c == 'b' || c == 'B') ? 1 : 0;
+		if (bits != 0) {
+			buf.sbumpc();
+			res = big_integer::read_power_of_two(buf, bits, digits);
+		}
+		else {
+			res = big_integer::read_decimal(buf, digits);
+			++digits;
+		}
+	}
+	else {
+		res = big_integer::read_decimal(buf, digits);
+	}
+
+	std::ios_base::iostate state = std::ios_base::goodbit;
+	if (traits::eq_int_type(buf.sgetc(), traits::eof())) {
+		state |= std::ios_base::eofbit;
+	}
+	if (digits == 0) {
+		state |= std::ios_base::failbit;
+	}
+	else {
+		a = negative ? -res : res;
+	}
+	in.setstate(state);
 	return in;
 }
 
@@ -688,22 +1357,17 @@ big_integer big_integer::apply_logical_operation(
 	big_integer const & rhs,
 	FunctorT logical_oper)
 {
-	big_integer lhs_adding = lhs->convert_to_2c();
-	big_integer rhs_adding = rhs.convert_to_2c();
-
-	size_t len = std::max(lhs_adding.get_data_size(), rhs_adding.get_data_size());
-	lhs_adding.data.resize(len);
-	rhs_adding.data.resize(len);
-
-	std::transform(lhs_adding.data.begin(), lhs_adding.data.end(),
-		rhs_adding.data.begin(),
-		lhs_adding.data.begin(),
+	// one extra chunk keeps the sign bit of both operands
+	size_t len = std::max(lhs->get_data_size(), rhs.get_data_size()) + 1;
+	seqset lhs_adding = lhs->twos_complement_data(len);
+	seqset rhs_adding = rhs.twos_complement_data(len);
+
+	std::transform(lhs_adding.begin(), lhs_adding.end(),
+		rhs_adding.begin(),
+		lhs_adding.begin(),
 		logical_oper);
 
-	int res_sign = logical_oper(lhs_adding.signum, rhs_adding.signum) & 2;
-	res_sign = -res_sign;
-
-	lhs_adding.signum = (lhs_adding.get_chunk(0) == 0) ? 0 : (res_sign + 1);
-	lhs_adding = lhs_adding.convert_to_2c();
-	return lhs_adding;
+	big_integer res;
+	res.assign_twos_complement(lhs_adding);
+	return res;
 }
\ No newline at end of file
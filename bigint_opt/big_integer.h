@@ -7,11 +7,36 @@
 
 #include <algorithm>
 #include <functional>
+#include <iosfwd>
 
 #define MAX_CHUNK_NUM UINT32_MAX
 
 using namespace std;
 
+struct big_integer;
+
+// fused evaluation of expression templates, see expression.h
+namespace expr {
+	struct term;
+	void evaluate(big_integer &dest, term const *terms, size_t count);
+}
+
+// execution policy of the multithreaded operations, see parallel.h
+namespace parallel {
+	struct policy;
+}
+
+// conversion from fixed_big_integer, see fixed_big_integer.h
+namespace fixed_detail {
+	big_integer to_big_integer(std::uint32_t const *chunks, size_t n, bool is_signed);
+}
+
+// chunks read or adopted by deserialize and import_words (see serialize.h)
+// and by mapped_big_integer_array (see mapped_array.h)
+namespace serial_detail {
+	void assign(big_integer &x, my_vector chunks, bool negative);
+}
+
 struct big_integer {
 private:
 	using uint = std::uint32_t;
@@ -30,20 +55,41 @@ private:
 	// multiplication
 	void mul_seqset_short(seqset &seq, uint val);
 	void mul_this_long_short(uint val);
+	// *this *= rhs on up to threads threads
+	big_integer& multiply(big_integer const &rhs, size_t threads);
 	big_integer mul_long_short(uint val) const;
 
 	// summation & subtract
 	void shifted_summation(seqset const &second, size_t shift);
+	// *this += sign * a * b in place; a and b must not share data's buffer
+	void accumulate(seqset const &a, seqset const &b, int sign);
 	big_integer seqset_subtract(big_integer const &lhs, big_integer const &rhs);
 
 	// division
 	uint div_long_short(uint val);
-	int compare_prefix(big_integer const &first, big_integer const &second, size_t const prefix_size);
-	void prefix_subtract(big_integer &first, big_integer const &second, size_t const prefix_size);
+	void divide_abs(big_integer const &rhs, big_integer &quotient, big_integer &remainder) const;
 
-	int str_to_bint(const string &str, big_integer &number);
+	int str_to_bint(const string &str, big_integer &number, size_t threads);
+
+	// decimal conversion through a cached table of 10^(9 * 2^level); the two
+	// halves of each split run on separate threads while threads > 1
+	static big_integer decimal_power(size_t level);
+	static std::string decimal_string(big_integer const &number, char separator, size_t threads);
+	// |number| < 10^width as exactly width digits at out, out is zero-filled
+	static void write_decimal(big_integer const &number, char *out, size_t width, size_t threads);
+	static big_integer read_decimal(std::string const &str, size_t from, size_t to, size_t threads);
+	// operator>>: the digits at the front of buf, as many as there are, digits counts them
+	static big_integer read_decimal(std::streambuf &buf, size_t &digits);
+	static big_integer read_power_of_two(std::streambuf &buf, unsigned bits, size_t &digits);
 
 	bool is_zero() const;
+	// 2^bit, with the chunks filled in directly: operator<< takes an int
+	static big_integer single_bit(size_t bit);
+
+	void assign_magnitude(seqset value);
+	seqset twos_complement_data(size_t len) const;
+	void assign_twos_complement(seqset value);
+	static void negate_twos_complement(seqset &value);
 	
 	template<typename FunctorT>
 	big_integer apply_logical_operation(
@@ -57,8 +103,11 @@ public:
 	big_integer(); 
 	big_integer(int a);
 	big_integer(uint a);
+	big_integer(ull a);
 	big_integer(big_integer const &other); 	
 	explicit big_integer(std::string const &str); 
+	// parsed on up to policy.threads threads, see parallel.h
+	big_integer(std::string const &str, parallel::policy const &policy);
 	~big_integer() = default; 
 
 	big_integer& operator=(big_integer const& other);
@@ -77,6 +126,17 @@ public:
 	big_integer& operator<<=(int rhs); 
 	big_integer& operator>>=(int rhs);
 
+	// bit queries on |*this|; bits are numbered from 0
+	size_t bit_length() const;
+	size_t popcount() const;
+	size_t ctz() const;
+
+	// single bits in two's complement, as &, |, ^ see them
+	bool test_bit(size_t bit) const;
+	big_integer& set_bit(size_t bit);
+	big_integer& clear_bit(size_t bit);
+	big_integer& flip_bit(size_t bit);
+
 	big_integer operator+() const; 
 	big_integer operator-() const; 
 	big_integer operator~() const; 
@@ -97,12 +157,30 @@ public:
 	size_t get_data_size() const;
 	seqset get_data() const;
 	uint get_chunk(size_t i) const;
+	big_integer get_chunks(size_t from, size_t to) const;
 
 	big_integer convert_to_2c() const;
 	friend int compare_abs_numbers(big_integer const &first, big_integer const &second);
 
 	friend std::string to_string(big_integer const& a);
 	friend std::string to_string(big_integer const& a, char separator);
+	friend std::string to_string(big_integer const& a, parallel::policy const &policy);
+	friend std::istream& operator>>(std::istream& in, big_integer& a);
+
+	friend big_integer mul(big_integer const &a, big_integer const &b, parallel::policy const &policy);
+
+	friend void addmul(big_integer &acc, big_integer const &a, big_integer const &b);
+	friend void submul(big_integer &acc, big_integer const &a, big_integer const &b);
+	friend void addmul_ui(big_integer &acc, big_integer const &a, std::uint64_t b);
+
+	friend big_integer divexact(big_integer const &a, big_integer const &b);
+	friend bool divisible_by(big_integer const &a, big_integer const &b);
+
+	friend class big_accumulator;
+
+	friend void expr::evaluate(big_integer &dest, expr::term const *terms, size_t count);
+	friend big_integer fixed_detail::to_big_integer(std::uint32_t const *chunks, size_t n, bool is_signed);
+	friend void serial_detail::assign(big_integer &x, my_vector chunks, bool negative);
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -118,6 +196,23 @@ big_integer operator^(big_integer a, big_integer const& b);
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
+big_integer pow(big_integer const& base, std::uint64_t exp);
+
+// a * b, splitting products of more than PARALLEL_MUL_THRESHOLD chunks across
+// up to policy.threads threads
+big_integer mul(big_integer const &a, big_integer const &b, parallel::policy const &policy);
+
+// acc += a * b, acc -= a * b, acc += a * b for a word b, accumulated in acc's buffer
+void addmul(big_integer &acc, big_integer const &a, big_integer const &b);
+void submul(big_integer &acc, big_integer const &a, big_integer const &b);
+void addmul_ui(big_integer &acc, big_integer const &a, std::uint64_t b);
+
+// a / b for a b known to divide a (binomials, fractions after a gcd), by Hensel
+// division: cheaper than operator/, but the result is garbage if b does not divide a
+big_integer divexact(big_integer const &a, big_integer const &b);
+// whether b divides a (0 divides only 0), without building the quotient
+bool divisible_by(big_integer const &a, big_integer const &b);
+
 bool operator==(big_integer const& a, big_integer const& b);
 bool operator!=(big_integer const& a, big_integer const& b);
 bool operator<(big_integer const& a, big_integer const& b);
@@ -126,6 +221,9 @@ bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
 std::ostream& operator<<(std::ostream& out, big_integer const& a);
+// an optional sign, then decimal digits, or hexadecimal ones after 0x or binary
+// ones after 0b; reads straight from the stream buffer up to the first other
+// character and sets failbit if there are no digits
 std::istream& operator>>(std::istream& in, big_integer& a);
 
 int compare_abs_numbers(big_integer const &first, big_integer const &second);
@@ -0,0 +1,114 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "combinatorics.h"
+#include "primes.h"
+
+#include <algorithm>
+#include <vector>
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+
+// packs factors into as few chunk-sized words as possible
+static std::vector<uint> pack_factors(std::vector<uint> const &factors)
+{
+	std::vector<uint> words;
+	ull cur = 1;
+	for (uint f : factors) {
+		if (cur * f > UINT32_MAX) {
+			words.push_back((uint)cur);
+			cur = 1;
+		}
+		cur *= f;
+	}
+	if (cur != 1 || words.empty()) {
+		words.push_back((uint)cur);
+	}
+	return words;
+}
+
+// balanced product tree over words[from, to)
+static big_integer product(std::vector<uint> const &words, size_t from, size_t to)
+{
+	if (to - from <= 8) {
+		big_integer res(1);
+		for (size_t i = from; i != to; ++i) {
+			res *= big_integer(words[i]);
+		}
+		return res;
+	}
+	size_t mid = from + (to - from) / 2;
+	return product(words, from, mid) * product(words, mid, to);
+}
+
+static big_integer product(std::vector<uint> const &factors)
+{
+	std::vector<uint> words = pack_factors(factors);
+	return product(words, 0, words.size());
+}
+
+// exponent of p in C(n, k): number of borrows subtracting k from n in base p
+static unsigned binomial_exponent(uint n, uint k, uint p)
+{
+	unsigned exp = 0;
+	uint borrow = 0;
+	while (n != 0) {
+		uint n_digit = n % p, k_digit = k % p + borrow;
+		borrow = (n_digit < k_digit) ? 1 : 0;
+		exp += borrow;
+		n /= p;
+		k /= p;
+	}
+	return exp;
+}
+
+// swing(n) = n! / ((n / 2)!)^2, built from its prime factorisation
+static big_integer swing(uint n, std::vector<uint> const &primes)
+{
+	std::vector<uint> factors;
+	for (uint p : primes) {
+		if (p > n) {
+			break;
+		}
+		for (uint q = n / p; q != 0; q /= p) {
+			if (q & 1) {
+				factors.push_back(p);
+			}
+		}
+	}
+	return product(factors);
+}
+
+static big_integer prime_swing_factorial(uint n, std::vector<uint> const &primes)
+{
+	if (n < 2) {
+		return 1;
+	}
+	big_integer half = prime_swing_factorial(n / 2, primes);
+	return half * half * swing(n, primes);
+}
+
+big_integer factorial(unsigned n)
+{
+	return prime_swing_factorial(n, primes_up_to(n));
+}
+
+big_integer binomial(unsigned n, unsigned k)
+{
+	if (k > n) {
+		return 0;
+	}
+	k = std::min(k, n - k);
+
+	std::vector<uint> factors;
+	for (uint p : primes_up_to(n)) {
+		unsigned exp = binomial_exponent(n, k, p);
+		factors.insert(factors.end(), exp, p);
+	}
+	return product(factors);
+}
+
+big_integer primorial(unsigned n)
+{
+	return product(primes_up_to(n));
+}
@@ -0,0 +1,15 @@
+#ifndef BIG_INTEGER_COMBINATORICS_H
+#define BIG_INTEGER_COMBINATORICS_H
+
+#include "big_integer.h"
+
+// n!
+big_integer factorial(unsigned n);
+
+// C(n, k), 0 for k > n
+big_integer binomial(unsigned n, unsigned k);
+
+// product of all primes p <= n
+big_integer primorial(unsigned n);
+
+#endif // BIG_INTEGER_COMBINATORICS_H
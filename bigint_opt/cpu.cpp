@@ -0,0 +1,96 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "cpu.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAVE_CPUID
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_BUILTIN_CPU_SUPPORTS
+#endif
+
+namespace cpu {
+#if defined(HAVE_CPUID)
+	namespace {
+		// CPUID leaf 7 bits, valid only together with the OS check below
+		constexpr int AVX2_BIT = 5;
+		constexpr int AVX512F_BIT = 16;
+		constexpr int AVX512IFMA_BIT = 21;
+
+		bool leaf7_ebx(int bit)
+		{
+			int regs[4];
+			__cpuid(regs, 0);
+			if (regs[0] < 7) {
+				return false;
+			}
+			__cpuidex(regs, 7, 0);
+			return (regs[1] >> bit) & 1;
+		}
+
+		// XCR0 bits the OS sets when it saves the ymm (mask 0x6) or zmm (mask 0xe6) state
+		bool os_saves(unsigned long long mask)
+		{
+			int regs[4];
+			__cpuid(regs, 1);
+			if (!((regs[2] >> 27) & 1)) {
+				return false;
+			}
+			return (_xgetbv(0) & mask) == mask;
+		}
+	}
+
+	bool has_avx2()
+	{
+		static bool const res = leaf7_ebx(AVX2_BIT) && os_saves(0x6);
+		return res;
+	}
+
+	bool has_avx512f()
+	{
+		static bool const res = leaf7_ebx(AVX512F_BIT) && os_saves(0xe6);
+		return res;
+	}
+
+	bool has_avx512ifma()
+	{
+		static bool const res = has_avx512f() && leaf7_ebx(AVX512IFMA_BIT);
+		return res;
+	}
+#elif defined(HAVE_BUILTIN_CPU_SUPPORTS)
+	// __builtin_cpu_supports checks the OS support as well; __builtin_cpu_init
+	// is needed when the first call comes from a static initializer
+	bool has_avx2()
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	}
+
+	bool has_avx512f()
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f");
+	}
+
+	bool has_avx512ifma()
+	{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+	}
+#else
+	bool has_avx2()
+	{
+		return false;
+	}
+
+	bool has_avx512f()
+	{
+		return false;
+	}
+
+	bool has_avx512ifma()
+	{
+		return false;
+	}
+#endif
+}
@@ -0,0 +1,28 @@
+#ifndef OPTS_CPU_H
+#define OPTS_CPU_H
+
+// Instruction set extensions of the running CPU, for kernels chosen at run time.
+// Each one also requires the OS to save the registers it uses. All are false
+// on other architectures and on compilers without a way to ask.
+namespace cpu {
+	bool has_avx2();
+	// AVX-512 foundation
+	bool has_avx512f();
+	// AVX-512 integer fused multiply-add (52-bit multiplies), implies has_avx512f
+	bool has_avx512ifma();
+}
+
+// HAVE_X86_SIMD: the x86 intrinsics are available. Functions using an extension
+// beyond the build's baseline are marked SIMD_TARGET("<extension>,...") and may
+// only be called once the matching check above returned true.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#define SIMD_TARGET(isa)
+#endif
+
+#endif // OPTS_CPU_H
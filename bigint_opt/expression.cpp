@@ -0,0 +1,86 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "expression.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace expr {
+	using uint = std::uint32_t;
+
+	void evaluate(big_integer &dest, term const *terms, size_t count)
+	{
+		// two's complement accumulator, one spare chunk holds the sign and the carries
+		size_t len = 1;
+		for (size_t i = 0; i != count; ++i) {
+			size_t size = terms[i].a->data.size() + (terms[i].b ? terms[i].b->data.size() : 0);
+			len = std::max(len, size);
+		}
+		len += 1;
+
+		my_vector res_data(len, 0);
+		uint *res = res_data.begin();
+		std::vector<uint> scratch;
+
+		for (size_t i = 0; i != count; ++i) {
+			term const &t = terms[i];
+			int sign = t.sign * t.a->signum * (t.b ? t.b->signum : 1);
+			if (sign == 0) {
+				continue;
+			}
+
+			my_vector const &a_data = t.a->data;
+			uint const *a = a_data.begin();
+			size_t an = a_data.size();
+			if (t.b == nullptr) {
+				if (sign > 0) {
+					limbs::add(res, res, len, a, an);
+				}
+				else {
+					limbs::sub(res, res, len, a, an);
+				}
+				continue;
+			}
+
+			my_vector const &b_data = t.b->data;
+			uint const *b = b_data.begin();
+			size_t bn = b_data.size();
+			if (an < bn) {
+				std::swap(a, b);
+				std::swap(an, bn);
+			}
+
+			if (bn < KARATSUBA_MUL_THRESHOLD) {
+				// one addmul row per chunk of b, no product is built
+				for (size_t j = 0; j != bn; ++j) {
+					if (sign > 0) {
+						uint carry = limbs::addmul_1(res + j, a, an, b[j]);
+						limbs::add_1(res + j + an, res + j + an, len - j - an, carry);
+					}
+					else {
+						uint borrow = limbs::submul_1(res + j, a, an, b[j]);
+						limbs::sub_1(res + j + an, res + j + an, len - j - an, borrow);
+					}
+				}
+				continue;
+			}
+
+			scratch.resize(an + bn);
+			if (a == b && an == bn) {
+				limbs::sqr(scratch.data(), a, an);
+			}
+			else {
+				limbs::mul(scratch.data(), a, an, b, bn);
+			}
+			if (sign > 0) {
+				limbs::add(res, res, len, scratch.data(), an + bn);
+			}
+			else {
+				limbs::sub(res, res, len, scratch.data(), an + bn);
+			}
+		}
+
+		dest.assign_twos_complement(res_data);
+	}
+}
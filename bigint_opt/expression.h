@@ -0,0 +1,231 @@
+#ifndef BIG_INTEGER_EXPRESSION_H
+#define BIG_INTEGER_EXPRESSION_H
+
+#include "big_integer.h"
+
+#include <array>
+#include <cstddef>
+
+// Expression templates over big_integer.
+//
+//     big_integer r = expr::eval(expr::lazy(a) * b + expr::lazy(c) * d - e);
+//
+// Once one operand is wrapped in expr::lazy, +, - and * build a tree instead of
+// temporaries. Evaluation flattens it into a signed sum of values and products
+// and accumulates all of them in one result buffer: small products are added
+// row by row with limbs::addmul_1 / submul_1, large ones go through a single
+// scratch buffer. An operand of a product that is itself a sum is evaluated
+// into a temporary first.
+//
+// Operands are held by reference, so an expression must not outlive them;
+// the destination may be one of the operands.
+namespace expr {
+	// sign * a, or sign * a * b
+	struct term {
+		int sign;
+		big_integer const *a;
+		big_integer const *b;
+	};
+
+	template<typename E>
+	struct expression {
+		E const &self() const {
+			return static_cast<E const &>(*this);
+		}
+	};
+
+	template<typename E>
+	big_integer &assign(big_integer &dest, expression<E> const &e);
+
+	template<typename E>
+	big_integer eval(expression<E> const &e) {
+		big_integer res;
+		assign(res, e);
+		return res;
+	}
+
+	// a big_integer operand
+	struct leaf : expression<leaf> {
+		static constexpr size_t terms = 1;
+		static constexpr size_t temporaries = 0;
+
+		big_integer const &value;
+
+		explicit leaf(big_integer const &value)
+			: value(value) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&) const {
+			*out++ = {sign, &value, nullptr};
+		}
+	};
+
+	// an int operand, stored in the tree
+	struct constant : expression<constant> {
+		static constexpr size_t terms = 1;
+		static constexpr size_t temporaries = 0;
+
+		big_integer value;
+
+		explicit constant(int value)
+			: value(value) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&) const {
+			*out++ = {sign, &value, nullptr};
+		}
+	};
+
+	// a factor of a product: leaves are used in place, anything else is evaluated
+	template<typename E>
+	struct factor {
+		static constexpr size_t temporaries = 1;
+
+		static big_integer const *get(E const &e, big_integer *&temp) {
+			assign(*temp, e);
+			return temp++;
+		}
+	};
+
+	template<>
+	struct factor<leaf> {
+		static constexpr size_t temporaries = 0;
+
+		static big_integer const *get(leaf const &e, big_integer *&) {
+			return &e.value;
+		}
+	};
+
+	template<>
+	struct factor<constant> {
+		static constexpr size_t temporaries = 0;
+
+		static big_integer const *get(constant const &e, big_integer *&) {
+			return &e.value;
+		}
+	};
+
+	template<typename L, typename R>
+	struct sum : expression<sum<L, R>> {
+		static constexpr size_t terms = L::terms + R::terms;
+		static constexpr size_t temporaries = L::temporaries + R::temporaries;
+
+		L lhs;
+		R rhs;
+
+		sum(L const &lhs, R const &rhs)
+			: lhs(lhs), rhs(rhs) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&temp) const {
+			lhs.collect(sign, out, temp);
+			rhs.collect(sign, out, temp);
+		}
+	};
+
+	template<typename L, typename R>
+	struct difference : expression<difference<L, R>> {
+		static constexpr size_t terms = L::terms + R::terms;
+		static constexpr size_t temporaries = L::temporaries + R::temporaries;
+
+		L lhs;
+		R rhs;
+
+		difference(L const &lhs, R const &rhs)
+			: lhs(lhs), rhs(rhs) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&temp) const {
+			lhs.collect(sign, out, temp);
+			rhs.collect(-sign, out, temp);
+		}
+	};
+
+	template<typename L, typename R>
+	struct product : expression<product<L, R>> {
+		static constexpr size_t terms = 1;
+		static constexpr size_t temporaries = factor<L>::temporaries + factor<R>::temporaries;
+
+		L lhs;
+		R rhs;
+
+		product(L const &lhs, R const &rhs)
+			: lhs(lhs), rhs(rhs) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&temp) const {
+			big_integer const *a = factor<L>::get(lhs, temp);
+			big_integer const *b = factor<R>::get(rhs, temp);
+			*out++ = {sign, a, b};
+		}
+	};
+
+	template<typename E>
+	struct negation : expression<negation<E>> {
+		static constexpr size_t terms = E::terms;
+		static constexpr size_t temporaries = E::temporaries;
+
+		E operand;
+
+		explicit negation(E const &operand)
+			: operand(operand) {
+		}
+
+		void collect(int sign, term *&out, big_integer *&temp) const {
+			operand.collect(-sign, out, temp);
+		}
+	};
+
+	inline leaf lazy(big_integer const &value) {
+		return leaf(value);
+	}
+
+	// a temporary would be gone before the expression is evaluated
+	leaf lazy(big_integer &&value) = delete;
+
+	template<typename E>
+	big_integer &assign(big_integer &dest, expression<E> const &e) {
+		std::array<term, E::terms> terms;
+		std::array<big_integer, E::temporaries> temporaries;
+		term *out = terms.data();
+		big_integer *temp = temporaries.data();
+		e.self().collect(1, out, temp);
+		evaluate(dest, terms.data(), (size_t)(out - terms.data()));
+		return dest;
+	}
+
+#define BIG_INTEGER_EXPRESSION_OPERATOR(op, node) \
+	template<typename L, typename R> \
+	node<L, R> operator op(expression<L> const &lhs, expression<R> const &rhs) { \
+		return node<L, R>(lhs.self(), rhs.self()); \
+	} \
+	template<typename L> \
+	node<L, leaf> operator op(expression<L> const &lhs, big_integer const &rhs) { \
+		return node<L, leaf>(lhs.self(), leaf(rhs)); \
+	} \
+	template<typename R> \
+	node<leaf, R> operator op(big_integer const &lhs, expression<R> const &rhs) { \
+		return node<leaf, R>(leaf(lhs), rhs.self()); \
+	} \
+	template<typename L> \
+	node<L, constant> operator op(expression<L> const &lhs, int rhs) { \
+		return node<L, constant>(lhs.self(), constant(rhs)); \
+	} \
+	template<typename R> \
+	node<constant, R> operator op(int lhs, expression<R> const &rhs) { \
+		return node<constant, R>(constant(lhs), rhs.self()); \
+	}
+
+	BIG_INTEGER_EXPRESSION_OPERATOR(+, sum)
+	BIG_INTEGER_EXPRESSION_OPERATOR(-, difference)
+	BIG_INTEGER_EXPRESSION_OPERATOR(*, product)
+
+#undef BIG_INTEGER_EXPRESSION_OPERATOR
+
+	template<typename E>
+	negation<E> operator-(expression<E> const &e) {
+		return negation<E>(e.self());
+	}
+}
+
+#endif // BIG_INTEGER_EXPRESSION_H
@@ -0,0 +1,36 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "fixed_big_integer.h"
+
+#include <algorithm>
+
+namespace fixed_detail {
+	void from_big_integer(big_integer const &x, uint *chunks, size_t n)
+	{
+		my_vector const data = x.get_data();
+		size_t len = std::min(n, data.size());
+		std::copy(data.begin(), data.begin() + len, chunks);
+		std::fill(chunks + len, chunks + n, 0);
+		if (x.signum < 0) {
+			for (size_t i = 0; i != n; ++i) {
+				chunks[i] = ~chunks[i];
+			}
+			limbs::add_1(chunks, chunks, n, 1);
+		}
+	}
+
+	big_integer to_big_integer(uint const *chunks, size_t n, bool is_signed)
+	{
+		// one extra chunk carries the sign into assign_twos_complement
+		my_vector value(n + 1, 0);
+		uint *out = value.begin();
+		std::copy(chunks, chunks + n, out);
+		if (is_signed && (chunks[n - 1] >> 31) != 0) {
+			out[n] = ~0u;
+		}
+
+		big_integer res;
+		res.assign_twos_complement(value);
+		return res;
+	}
+}
@@ -0,0 +1,427 @@
+#ifndef BIG_INTEGER_FIXED_H
+#define BIG_INTEGER_FIXED_H
+
+#include "big_integer.h"
+#include "limbs.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// operands up to this many chunks get fully unrolled add, sub and mul,
+// larger ones run the same steps in a loop
+#ifndef FIXED_UNROLL_LIMIT
+#define FIXED_UNROLL_LIMIT 32
+#endif
+
+// true while a constant expression is being evaluated; lets division use
+// limbs::divrem at run time. Without the builtin division is run-time only.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define FIXED_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(FIXED_CONSTANT_EVALUATED) && ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define FIXED_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#ifndef FIXED_CONSTANT_EVALUATED
+#define FIXED_CONSTANT_EVALUATED() false
+#endif
+
+namespace fixed_detail {
+	using uint = std::uint32_t;
+
+	// x mod 2^(32 n), negative values in two's complement
+	void from_big_integer(big_integer const &x, uint *chunks, size_t n);
+	// the value of n chunks, read as two's complement if is_signed
+	big_integer to_big_integer(uint const *chunks, size_t n, bool is_signed);
+
+	// limbs::add_n, sub_n and addmul_1 unrolled over a fixed number of chunks
+
+	template<size_t... I>
+	constexpr uint add(uint *r, uint const *a, uint const *b, std::index_sequence<I...>)
+	{
+		uint carry = 0;
+		((r[I] = limbs::add_with_carry(a[I], b[I], carry)), ...);
+		return carry;
+	}
+
+	template<size_t... I>
+	constexpr uint sub(uint *r, uint const *a, uint const *b, std::index_sequence<I...>)
+	{
+		uint borrow = 0;
+		((r[I] = limbs::sub_with_borrow(a[I], b[I], borrow)), ...);
+		return borrow;
+	}
+
+	// r += a * b over sizeof...(I) chunks, the carry out of the top is dropped
+	template<size_t... I>
+	constexpr void addmul_row(uint *r, uint const *a, uint b, std::index_sequence<I...>)
+	{
+		uint carry = 0;
+		((r[I] = limbs::mul_add(a[I], b, r[I], carry)), ...);
+	}
+
+	// r = a * b mod 2^(32 N); r is zero and does not alias a or b
+	template<size_t N, size_t... I>
+	constexpr void mul_low(uint *r, uint const *a, uint const *b, std::index_sequence<I...>)
+	{
+		(addmul_row(r + I, a, b[I], std::make_index_sequence<N - I>()), ...);
+	}
+}
+
+// Integer of Bits bits (a multiple of 32) held in a std::array: no heap, no
+// copy-on-write, no trimming. Arithmetic wraps around modulo 2^Bits. With Signed
+// the same bits are read as two's complement, which only changes comparison,
+// division, >> and conversion to big_integer.
+//
+// Everything but the conversions from and to big_integer is constexpr, so
+// constants and tables can be computed at compile time, see operator""_bi.
+template<size_t Bits, bool Signed = false>
+class fixed_big_integer {
+	static_assert(Bits != 0 && Bits % 32 == 0, "Bits must be a positive multiple of 32");
+
+public:
+	using uint = std::uint32_t;
+	using ull = std::uint64_t;
+
+	static constexpr size_t CHUNKS = Bits / 32;
+
+	constexpr fixed_big_integer()
+		: chunks() {
+	}
+
+	// sign-extended for negative values
+	template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+	constexpr fixed_big_integer(T value)
+		: chunks() {
+		bool negative = false;
+		if constexpr (std::is_signed<T>::value) {
+			negative = value < 0;
+		}
+		ull bits = (ull)value;
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			chunks[i] = (i < 2) ? (uint)(bits >> (32 * i)) : (negative ? ~0u : 0u);
+		}
+	}
+
+	// truncated, or sign-extended if other is negative
+	template<size_t OtherBits, bool OtherSigned>
+	constexpr explicit fixed_big_integer(fixed_big_integer<OtherBits, OtherSigned> const &other)
+		: chunks() {
+		uint fill = other.is_negative() ? ~0u : 0u;
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			chunks[i] = (i < OtherBits / 32) ? other.get_chunk(i) : fill;
+		}
+	}
+
+	// value mod 2^Bits
+	explicit fixed_big_integer(big_integer const &value) {
+		fixed_detail::from_big_integer(value, chunks.data(), CHUNKS);
+	}
+
+	explicit fixed_big_integer(std::string const &str)
+		: fixed_big_integer(big_integer(str)) {
+	}
+
+	// copies the chunks, no decimal conversion
+	big_integer to_big_integer() const {
+		return fixed_detail::to_big_integer(chunks.data(), CHUNKS, Signed);
+	}
+
+	explicit operator big_integer() const {
+		return to_big_integer();
+	}
+
+	constexpr uint get_chunk(size_t i) const {
+		return chunks[i];
+	}
+
+	constexpr uint *data() {
+		return chunks.data();
+	}
+
+	constexpr uint const *data() const {
+		return chunks.data();
+	}
+
+	constexpr bool is_negative() const {
+		return Signed && (chunks[CHUNKS - 1] >> 31) != 0;
+	}
+
+	// bits in |*this|, 0 for zero
+	constexpr size_t bit_length() const {
+		fixed_big_integer abs = is_negative() ? -*this : *this;
+		size_t n = limbs::normalized_size(abs.chunks.data(), CHUNKS);
+		return (n == 0) ? 0 : 32 * (n - 1) + limbs::bit_length(abs.chunks[n - 1]);
+	}
+
+	constexpr fixed_big_integer &operator+=(fixed_big_integer const &rhs) {
+		if constexpr (CHUNKS <= FIXED_UNROLL_LIMIT) {
+			fixed_detail::add(chunks.data(), chunks.data(), rhs.chunks.data(), std::make_index_sequence<CHUNKS>());
+		}
+		else {
+			limbs::add_n(chunks.data(), chunks.data(), rhs.chunks.data(), CHUNKS);
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator-=(fixed_big_integer const &rhs) {
+		if constexpr (CHUNKS <= FIXED_UNROLL_LIMIT) {
+			fixed_detail::sub(chunks.data(), chunks.data(), rhs.chunks.data(), std::make_index_sequence<CHUNKS>());
+		}
+		else {
+			limbs::sub_n(chunks.data(), chunks.data(), rhs.chunks.data(), CHUNKS);
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator*=(fixed_big_integer const &rhs) {
+		fixed_big_integer res;
+		if constexpr (CHUNKS <= FIXED_UNROLL_LIMIT) {
+			fixed_detail::mul_low<CHUNKS>(res.chunks.data(), chunks.data(), rhs.chunks.data(),
+				std::make_index_sequence<CHUNKS>());
+		}
+		else {
+			for (size_t i = 0; i != CHUNKS; ++i) {
+				limbs::addmul_1(res.chunks.data() + i, chunks.data(), CHUNKS - i, rhs.chunks[i]);
+			}
+		}
+		return *this = res;
+	}
+
+	// truncating, as for built-in integers
+	constexpr fixed_big_integer &operator/=(fixed_big_integer const &rhs) {
+		fixed_big_integer remainder;
+		divide(*this, rhs, *this, remainder);
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator%=(fixed_big_integer const &rhs) {
+		fixed_big_integer quotient;
+		divide(*this, rhs, quotient, *this);
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator&=(fixed_big_integer const &rhs) {
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			chunks[i] &= rhs.chunks[i];
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator|=(fixed_big_integer const &rhs) {
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			chunks[i] |= rhs.chunks[i];
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator^=(fixed_big_integer const &rhs) {
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			chunks[i] ^= rhs.chunks[i];
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer &operator<<=(int shift) {
+		if (shift < 0) {
+			return *this >>= -shift;
+		}
+		size_t whole = (size_t)shift / 32;
+		unsigned bits = (unsigned)shift % 32;
+		for (size_t i = CHUNKS; i-- != 0;) {
+			uint high = (i >= whole) ? chunks[i - whole] : 0;
+			uint low = (i > whole) ? chunks[i - whole - 1] : 0;
+			chunks[i] = (bits == 0) ? high : (high << bits) | (low >> (32 - bits));
+		}
+		return *this;
+	}
+
+	// arithmetic for Signed, logical otherwise
+	constexpr fixed_big_integer &operator>>=(int shift) {
+		if (shift < 0) {
+			return *this <<= -shift;
+		}
+		uint fill = is_negative() ? ~0u : 0u;
+		size_t whole = (size_t)shift / 32;
+		unsigned bits = (unsigned)shift % 32;
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			uint low = (whole < CHUNKS - i) ? chunks[i + whole] : fill;
+			uint high = (whole + 1 < CHUNKS - i) ? chunks[i + whole + 1] : fill;
+			chunks[i] = (bits == 0) ? low : (low >> bits) | (high << (32 - bits));
+		}
+		return *this;
+	}
+
+	constexpr fixed_big_integer operator+() const {
+		return *this;
+	}
+
+	constexpr fixed_big_integer operator-() const {
+		fixed_big_integer res;
+		return res -= *this;
+	}
+
+	constexpr fixed_big_integer operator~() const {
+		fixed_big_integer res;
+		for (size_t i = 0; i != CHUNKS; ++i) {
+			res.chunks[i] = ~chunks[i];
+		}
+		return res;
+	}
+
+	friend constexpr fixed_big_integer operator+(fixed_big_integer a, fixed_big_integer const &b) { return a += b; }
+	friend constexpr fixed_big_integer operator-(fixed_big_integer a, fixed_big_integer const &b) { return a -= b; }
+	friend constexpr fixed_big_integer operator*(fixed_big_integer a, fixed_big_integer const &b) { return a *= b; }
+	friend constexpr fixed_big_integer operator/(fixed_big_integer a, fixed_big_integer const &b) { return a /= b; }
+	friend constexpr fixed_big_integer operator%(fixed_big_integer a, fixed_big_integer const &b) { return a %= b; }
+	friend constexpr fixed_big_integer operator&(fixed_big_integer a, fixed_big_integer const &b) { return a &= b; }
+	friend constexpr fixed_big_integer operator|(fixed_big_integer a, fixed_big_integer const &b) { return a |= b; }
+	friend constexpr fixed_big_integer operator^(fixed_big_integer a, fixed_big_integer const &b) { return a ^= b; }
+	friend constexpr fixed_big_integer operator<<(fixed_big_integer a, int b) { return a <<= b; }
+	friend constexpr fixed_big_integer operator>>(fixed_big_integer a, int b) { return a >>= b; }
+
+	friend constexpr bool operator==(fixed_big_integer const &a, fixed_big_integer const &b) {
+		return limbs::cmp(a.chunks.data(), b.chunks.data(), CHUNKS) == 0;
+	}
+
+	friend constexpr bool operator!=(fixed_big_integer const &a, fixed_big_integer const &b) {
+		return !(a == b);
+	}
+
+	friend constexpr bool operator<(fixed_big_integer const &a, fixed_big_integer const &b) {
+		if (a.is_negative() != b.is_negative()) {
+			return a.is_negative();
+		}
+		return limbs::cmp(a.chunks.data(), b.chunks.data(), CHUNKS) < 0;
+	}
+
+	friend constexpr bool operator>(fixed_big_integer const &a, fixed_big_integer const &b) {
+		return b < a;
+	}
+
+	friend constexpr bool operator<=(fixed_big_integer const &a, fixed_big_integer const &b) {
+		return !(b < a);
+	}
+
+	friend constexpr bool operator>=(fixed_big_integer const &a, fixed_big_integer const &b) {
+		return !(a < b);
+	}
+
+	friend std::string to_string(fixed_big_integer const &a) {
+		return to_string(a.to_big_integer());
+	}
+
+private:
+	std::array<uint, CHUNKS> chunks;
+
+	// quotient and remainder may alias a or b
+	static constexpr void divide(fixed_big_integer const &a, fixed_big_integer const &b,
+		fixed_big_integer &quotient, fixed_big_integer &remainder) {
+		bool a_negative = a.is_negative(), b_negative = b.is_negative();
+		// magnitudes; the most negative value is its own magnitude read unsigned
+		fixed_big_integer a_abs = a_negative ? -a : a;
+		fixed_big_integer b_abs = b_negative ? -b : b;
+
+		size_t an = limbs::normalized_size(a_abs.chunks.data(), CHUNKS);
+		size_t bn = limbs::normalized_size(b_abs.chunks.data(), CHUNKS);
+		if (bn == 0) {
+			throw std::runtime_error("division by 0");
+		}
+
+		fixed_big_integer q, r;
+		if (an < bn) {
+			r = a_abs;
+		}
+		else if (bn == 1) {
+			r.chunks[0] = limbs::divrem_1(q.chunks.data(), a_abs.chunks.data(), an, b_abs.chunks[0]);
+		}
+		else if (FIXED_CONSTANT_EVALUATED()) {
+			divide_bitwise(a_abs, b_abs, an, bn, q, r);
+		}
+		else {
+			limbs::divrem(q.chunks.data(), r.chunks.data(), a_abs.chunks.data(), an, b_abs.chunks.data(), bn);
+		}
+
+		quotient = (a_negative != b_negative) ? -q : q;
+		remainder = a_negative ? -r : r;
+	}
+
+	// shift and subtract on magnitudes, for constant expressions; q and r are zero
+	static constexpr void divide_bitwise(fixed_big_integer const &a, fixed_big_integer const &b, size_t an, size_t bn,
+		fixed_big_integer &q, fixed_big_integer &r) {
+		uint *rem = r.chunks.data();
+		for (size_t bit = 32 * an; bit-- != 0;) {
+			// rem < b, so rem * 2 + 1 overflows bn chunks by at most one bit
+			uint carry = (a.chunks[bit / 32] >> (bit % 32)) & 1;
+			for (size_t i = 0; i != bn; ++i) {
+				uint next = rem[i] >> 31;
+				rem[i] = (rem[i] << 1) | carry;
+				carry = next;
+			}
+			if (carry != 0 || limbs::cmp(rem, b.chunks.data(), bn) >= 0) {
+				limbs::sub_n(rem, rem, b.chunks.data(), bn);
+				q.chunks[bit / 32] |= uint(1) << (bit % 32);
+			}
+		}
+	}
+};
+
+template<size_t Bits>
+using fixed_uint = fixed_big_integer<Bits, false>;
+
+template<size_t Bits>
+using fixed_int = fixed_big_integer<Bits, true>;
+
+namespace fixed_detail {
+	// an integer literal as the compiler hands it to operator""_bi:
+	// decimal, 0x hex, 0b binary or 0 octal, with ' separators
+	template<char... Digits>
+	struct literal {
+		static constexpr char digits[] = {Digits...};
+		static constexpr size_t count = sizeof...(Digits);
+
+		static constexpr bool prefixed = count > 2 && digits[0] == '0'
+			&& (digits[1] == 'x' || digits[1] == 'X' || digits[1] == 'b' || digits[1] == 'B');
+		static constexpr uint base = prefixed ? ((digits[1] == 'x' || digits[1] == 'X') ? 16 : 2)
+			: (count > 1 && digits[0] == '0') ? 8 : 10;
+
+		static constexpr uint digit(char c) {
+			return (c >= 'a') ? uint(c - 'a' + 10) : (c >= 'A') ? uint(c - 'A' + 10) : uint(c - '0');
+		}
+
+		template<size_t Bits>
+		static constexpr fixed_uint<Bits> value() {
+			fixed_uint<Bits> res;
+			for (size_t i = prefixed ? 2 : 0; i != count; ++i) {
+				if (digits[i] != '\'') {
+					limbs::mul_1(res.data(), res.data(), res.CHUNKS, base);
+					limbs::add_1(res.data(), res.data(), res.CHUNKS, digit(digits[i]));
+				}
+			}
+			return res;
+		}
+
+		// no digit takes more than 4 bits; the exact width is then read off the value
+		static constexpr size_t MAX_BITS = (4 * count + 31) / 32 * 32;
+		static constexpr size_t EXACT_BITS = value<MAX_BITS>().bit_length();
+		static constexpr size_t BITS = (EXACT_BITS == 0) ? 32 : (EXACT_BITS + 31) / 32 * 32;
+	};
+}
+
+namespace fixed_literals {
+	// 123456789012345678901234567890_bi is a fixed_uint just wide enough for the
+	// literal, computed at compile time; to_big_integer() on it copies chunks
+	// instead of parsing a string
+	template<char... Digits>
+	constexpr fixed_uint<fixed_detail::literal<Digits...>::BITS> operator""_bi() {
+		return fixed_detail::literal<Digits...>::template value<fixed_detail::literal<Digits...>::BITS>();
+	}
+}
+
+#endif // BIG_INTEGER_FIXED_H
@@ -0,0 +1,238 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "ifma.h"
+#include "cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace ifma {
+	namespace {
+		constexpr unsigned CHUNK_BITS = 32;
+		constexpr unsigned LIMB_BITS = 52;
+		constexpr ull LIMB_MASK = (ull(1) << LIMB_BITS) - 1;
+		// 64-bit lanes of a zmm register
+		constexpr size_t LANES = 8;
+
+		size_t limbs_for(size_t chunks)
+		{
+			return (chunks * CHUNK_BITS + LIMB_BITS - 1) / LIMB_BITS;
+		}
+
+		size_t padded(size_t limbs)
+		{
+			return (limbs + LANES - 1) / LANES * LANES;
+		}
+
+		// the n chunks of a as r.size() limbs, zero above a
+		void to_limbs(std::vector<ull> &r, uint const *a, size_t n)
+		{
+			for (size_t t = 0; t != r.size(); ++t) {
+				size_t bit = t * LIMB_BITS, i = bit / CHUNK_BITS;
+				unsigned shift = bit % CHUNK_BITS;
+				ull v = 0;
+				// a limb spans up to three chunks
+				if (i < n) {
+					v = a[i] >> shift;
+				}
+				if (i + 1 < n) {
+					v |= (ull)a[i + 1] << (CHUNK_BITS - shift);
+				}
+				if (shift > 2 * CHUNK_BITS - LIMB_BITS && i + 2 < n) {
+					v |= (ull)a[i + 2] << (2 * CHUNK_BITS - shift);
+				}
+				r[t] = v & LIMB_MASK;
+			}
+		}
+
+		// the low n chunks of the k limbs of a
+		void from_limbs(uint *r, size_t n, ull const *a, size_t k)
+		{
+			for (size_t i = 0; i != n; ++i) {
+				size_t bit = i * CHUNK_BITS, t = bit / LIMB_BITS;
+				unsigned shift = bit % LIMB_BITS;
+				ull v = (t < k) ? a[t] >> shift : 0;
+				if (shift > LIMB_BITS - CHUNK_BITS && t + 1 < k) {
+					v |= a[t + 1] << (LIMB_BITS - shift);
+				}
+				r[i] = (uint)v;
+			}
+		}
+
+		// Products go into two arrays of 64-bit column sums, lo[c] collects the low
+		// 52 bits of the limb products of column c and hi[c] the high 52 bits of
+		// those of column c - 1; nothing is carried until normalize. A column sum
+		// stays below 2^64 for up to 2^11 products per column.
+
+		// r[t] = limb t of the column sums lo[t] + hi[t] plus carry, returns the
+		// carry out of the last one
+		ull normalize(ull *r, size_t k, ull const *lo, ull const *hi, ull carry)
+		{
+			for (size_t t = 0; t != k; ++t) {
+				ull sum = lo[t] + hi[t] + carry;
+				r[t] = sum & LIMB_MASK;
+				carry = sum >> LIMB_BITS;
+			}
+			return carry;
+		}
+
+#ifdef HAVE_X86_SIMD
+		// lo, hi += a * b in columns; a has a multiple of LANES limbs, the arrays
+		// ka + kb + 1 columns
+		SIMD_TARGET("avx512f,avx512ifma")
+		void mul_columns(ull *lo, ull *hi, ull const *a, size_t ka, ull const *b, size_t kb)
+		{
+			for (size_t i = 0; i != kb; ++i) {
+				__m512i bi = _mm512_set1_epi64((long long)b[i]);
+				for (size_t j = 0; j != ka; j += LANES) {
+					__m512i x = _mm512_loadu_si512(a + j);
+					ull *l = lo + i + j, *h = hi + i + j + 1;
+					_mm512_storeu_si512(l, _mm512_madd52lo_epu64(_mm512_loadu_si512(l), x, bi));
+					_mm512_storeu_si512(h, _mm512_madd52hi_epu64(_mm512_loadu_si512(h), x, bi));
+				}
+			}
+		}
+
+		// Montgomery reduction interleaved with the product, one limb of b per
+		// step (coarsely integrated operand scanning, as limbs::mont_mul). Step i
+		// adds a * b[i] and m * q at column i, q chosen so that column i becomes a
+		// multiple of 2^52; its carry moves on to column i + 1 and the columns from
+		// k up hold the result. Returns the carry into column k.
+		SIMD_TARGET("avx512f,avx512ifma")
+		ull mont_columns(ull *lo, ull *hi, ull const *a, ull const *b, ull const *m, size_t k, size_t kp, ull m_inv)
+		{
+			ull carry = 0;
+			for (size_t i = 0; i != k; ++i) {
+				ull low = lo[i] + hi[i] + carry + ((a[0] * b[i]) & LIMB_MASK);
+				ull q = ((low & LIMB_MASK) * m_inv) & LIMB_MASK;
+				__m512i bi = _mm512_set1_epi64((long long)b[i]);
+				__m512i qv = _mm512_set1_epi64((long long)q);
+				for (size_t j = 0; j != kp; j += LANES) {
+					__m512i x = _mm512_loadu_si512(a + j);
+					__m512i y = _mm512_loadu_si512(m + j);
+					ull *l = lo + i + j, *h = hi + i + j + 1;
+					__m512i lv = _mm512_madd52lo_epu64(_mm512_loadu_si512(l), x, bi);
+					_mm512_storeu_si512(l, _mm512_madd52lo_epu64(lv, y, qv));
+					__m512i hv = _mm512_madd52hi_epu64(_mm512_loadu_si512(h), x, bi);
+					_mm512_storeu_si512(h, _mm512_madd52hi_epu64(hv, y, qv));
+				}
+				carry = (lo[i] + hi[i] + carry) >> LIMB_BITS;
+			}
+			return carry;
+		}
+#else
+		void mul_columns(ull *, ull *, ull const *, size_t, ull const *, size_t)
+		{
+		}
+
+		ull mont_columns(ull *, ull *, ull const *, ull const *, ull const *, size_t, size_t, ull)
+		{
+			return 0;
+		}
+#endif
+
+		void check_supported()
+		{
+			if (!supported()) {
+				throw std::runtime_error("AVX-512 IFMA is not supported");
+			}
+		}
+
+		std::atomic<bool> enabled(true);
+	}
+
+	bool supported()
+	{
+#ifdef HAVE_X86_SIMD
+		return cpu::has_avx512ifma();
+#else
+		return false;
+#endif
+	}
+
+	bool active()
+	{
+		return enabled.load(std::memory_order_relaxed) && supported();
+	}
+
+	bool select(bool use)
+	{
+		enabled.store(use, std::memory_order_relaxed);
+		return active();
+	}
+
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn)
+	{
+		check_supported();
+		// vectors run along the longer operand
+		if (an < bn) {
+			std::swap(a, b);
+			std::swap(an, bn);
+		}
+		std::vector<ull> a52(padded(limbs_for(an))), b52(limbs_for(bn));
+		to_limbs(a52, a, an);
+		to_limbs(b52, b, bn);
+
+		size_t ka = a52.size(), kb = b52.size();
+		std::vector<ull> lo(ka + kb + 1, 0), hi(ka + kb + 1, 0), res(ka + kb);
+		mul_columns(lo.data(), hi.data(), a52.data(), ka, b52.data(), kb);
+		normalize(res.data(), ka + kb, lo.data(), hi.data(), 0);
+		from_limbs(r, an + bn, res.data(), ka + kb);
+	}
+
+	montgomery::montgomery(uint const *m, size_t n)
+		: n(n),
+		k(limbs_for(n)),
+		m_inv(0),
+		mod(padded(k)),
+		a52(padded(k)),
+		b52(k),
+		lo(k + padded(k) + 1),
+		hi(k + padded(k) + 1)
+	{
+		check_supported();
+		to_limbs(mod, m, n);
+		// -m^-1 mod 2^52, by Newton iteration as limbs::inverse_mod_base
+		ull x = mod[0];
+		for (int i = 0; i != 5; ++i) {
+			x *= 2 - mod[0] * x;
+		}
+		m_inv = (0 - x) & LIMB_MASK;
+	}
+
+	size_t montgomery::radix_bits() const
+	{
+		return k * LIMB_BITS;
+	}
+
+	void montgomery::mul(uint *r, uint const *a, uint const *b)
+	{
+		to_limbs(a52, a, n);
+		to_limbs(b52, b, n);
+		std::fill(lo.begin(), lo.end(), 0);
+		std::fill(hi.begin(), hi.end(), 0);
+		ull carry = mont_columns(lo.data(), hi.data(), a52.data(), b52.data(), mod.data(), k, mod.size(), m_inv);
+
+		// the result is below 2m, k limbs and one bit; b52 is free for it
+		ull *res = b52.data();
+		ull top = normalize(res, k, lo.data() + k, hi.data() + k, carry);
+		bool reduce = top != 0;
+		if (!reduce) {
+			size_t t = k;
+			while (t != 0 && res[t - 1] == mod[t - 1]) {
+				--t;
+			}
+			reduce = t == 0 || res[t - 1] > mod[t - 1];
+		}
+		if (reduce) {
+			ull borrow = 0;
+			for (size_t t = 0; t != k; ++t) {
+				ull diff = res[t] - mod[t] - borrow;
+				res[t] = diff & LIMB_MASK;
+				borrow = diff >> 63;
+			}
+		}
+		from_limbs(r, n, res, k);
+	}
+}
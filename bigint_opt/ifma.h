@@ -0,0 +1,53 @@
+#ifndef OPTS_IFMA_H
+#define OPTS_IFMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// AVX-512 IFMA kernels: the operands are converted to 52-bit limbs, multiplied
+// with vpmadd52luq / vpmadd52huq eight limbs at a time and converted back, so
+// the interfaces take and return 32-bit chunks like limbs.h.
+// While active(), limbs::mul and limbs::sqr use ifma::mul for operands of
+// IFMA_MUL_THRESHOLD to IFMA_MUL_LIMIT chunks (see tuning.h), and the prime
+// tests use ifma::montgomery for moduli from IFMA_MONT_THRESHOLD chunks up.
+namespace ifma {
+	using uint = std::uint32_t;
+	using ull = std::uint64_t;
+
+	// the CPU has AVX-512 IFMA
+	bool supported();
+	// supported() and not turned off by select
+	bool active();
+	// turns the IFMA paths on or off, returns active()
+	bool select(bool use);
+
+	// size limits in chunks, the 64-bit column sums overflow above them
+	constexpr size_t MUL_LIMIT = 2048;
+	constexpr size_t MONT_LIMIT = 1024;
+
+	// r = a * b, r has an + bn chunks and does not alias a or b; needs supported()
+	// and the shorter operand below MUL_LIMIT
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn);
+
+	// Montgomery multiplication modulo an odd m of n chunks, in radix R = 2^radix_bits(),
+	// the smallest multiple of 52 bits that holds m; needs supported() and n below MONT_LIMIT
+	class montgomery {
+	public:
+		montgomery(uint const *m, size_t n);
+
+		size_t radix_bits() const;
+		// r = a * b / R mod m, a, b < m, all of n chunks; r may alias a or b
+		void mul(uint *r, uint const *a, uint const *b);
+
+	private:
+		size_t n;
+		size_t k;
+		ull m_inv;
+		// radix 2^52, k limbs padded with zeros to whole vectors
+		std::vector<ull> mod;
+		std::vector<ull> a52, b52, lo, hi;
+	};
+}
+
+#endif // OPTS_IFMA_H
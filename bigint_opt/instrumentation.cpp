@@ -0,0 +1,165 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "instrumentation.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAVE_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+namespace instrumentation {
+	namespace {
+		constexpr size_t OPERATIONS = static_cast<size_t>(operation::count);
+
+		struct counters {
+			std::atomic<ull> calls;
+			std::atomic<ull> cycles;
+			std::atomic<ull> allocations;
+			std::atomic<ull> allocated_bytes;
+			std::atomic<ull> detaches;
+		};
+
+		counters table[OPERATIONS][BUCKETS];
+
+		char const *const NAMES[OPERATIONS] = {
+			"add", "sub", "mul", "div", "mod",
+			"and", "or", "xor", "shl", "shr",
+			"addmul", "cmp", "pow", "to_string", "parse"
+		};
+
+		ull read_cycles()
+		{
+#ifdef HAVE_RDTSC
+			return __rdtsc();
+#else
+			return (ull)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+	}
+
+	bool enabled()
+	{
+#ifdef BIGINT_INSTRUMENTATION
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	char const *name(operation op)
+	{
+		return NAMES[static_cast<size_t>(op)];
+	}
+
+	size_t bucket(size_t chunks)
+	{
+		size_t res = 0;
+		for (; chunks != 0; chunks >>= 1) {
+			++res;
+		}
+		return res;
+	}
+
+	op_stats stats(operation op, size_t bucket)
+	{
+		counters const &c = table[static_cast<size_t>(op)][bucket];
+		return {
+			c.calls.load(std::memory_order_relaxed),
+			c.cycles.load(std::memory_order_relaxed),
+			c.allocations.load(std::memory_order_relaxed),
+			c.allocated_bytes.load(std::memory_order_relaxed),
+			c.detaches.load(std::memory_order_relaxed)
+		};
+	}
+
+	op_stats stats(operation op)
+	{
+		op_stats res = {0, 0, 0, 0, 0};
+		for (size_t b = 0; b != BUCKETS; ++b) {
+			op_stats s = stats(op, b);
+			res.calls += s.calls;
+			res.cycles += s.cycles;
+			res.allocations += s.allocations;
+			res.allocated_bytes += s.allocated_bytes;
+			res.detaches += s.detaches;
+		}
+		return res;
+	}
+
+	void reset()
+	{
+		for (auto &row : table) {
+			for (counters &c : row) {
+				c.calls.store(0, std::memory_order_relaxed);
+				c.cycles.store(0, std::memory_order_relaxed);
+				c.allocations.store(0, std::memory_order_relaxed);
+				c.allocated_bytes.store(0, std::memory_order_relaxed);
+				c.detaches.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void dump(std::ostream &out)
+	{
+		if (!enabled()) {
+			out << "instrumentation is disabled, rebuild with BIGINT_INSTRUMENTATION\n";
+			return;
+		}
+		out << std::left << std::setw(10) << "operation"
+			<< std::right << std::setw(22) << "chunks"
+			<< std::setw(14) << "calls"
+			<< std::setw(18) << "cycles"
+			<< std::setw(14) << "cycles/call"
+			<< std::setw(14) << "allocations"
+			<< std::setw(16) << "bytes"
+			<< std::setw(12) << "detaches" << "\n";
+		for (size_t op = 0; op != OPERATIONS; ++op) {
+			for (size_t b = 0; b != BUCKETS; ++b) {
+				op_stats s = stats(static_cast<operation>(op), b);
+				if (s.calls == 0) {
+					continue;
+				}
+				// bucket b holds [2^(b-1), 2^b), bucket 0 is empty operands
+				ull low = (b == 0) ? 0 : (ull)1 << (b - 1);
+				ull high = (b == 0) ? 0 : low * 2 - 1;
+				out << std::left << std::setw(10) << NAMES[op]
+					<< std::right << std::setw(22) << (std::to_string(low) + ".." + std::to_string(high))
+					<< std::setw(14) << s.calls
+					<< std::setw(18) << s.cycles
+					<< std::setw(14) << s.cycles / s.calls
+					<< std::setw(14) << s.allocations
+					<< std::setw(16) << s.allocated_bytes
+					<< std::setw(12) << s.detaches << "\n";
+			}
+		}
+	}
+
+	scope::scope(operation op, size_t chunks)
+		: op(op), chunks(chunks),
+		start_cycles(read_cycles()),
+		start(my_vector::counters())
+	{
+	}
+
+	scope::~scope()
+	{
+		ull cycles = read_cycles() - start_cycles;
+		my_vector::hook_counters now = my_vector::counters();
+		counters &c = table[static_cast<size_t>(op)][bucket(chunks)];
+		c.calls.fetch_add(1, std::memory_order_relaxed);
+		c.cycles.fetch_add(cycles, std::memory_order_relaxed);
+		c.allocations.fetch_add(now.allocations - start.allocations, std::memory_order_relaxed);
+		c.allocated_bytes.fetch_add(now.allocated_bytes - start.allocated_bytes, std::memory_order_relaxed);
+		c.detaches.fetch_add(now.detaches - start.detaches, std::memory_order_relaxed);
+	}
+}
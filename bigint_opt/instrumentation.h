@@ -0,0 +1,74 @@
+#ifndef OPTS_INSTRUMENTATION_H
+#define OPTS_INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "my_vector.h"
+
+// Per-operation counters, compiled in only when BIGINT_INSTRUMENTATION is defined
+// (cmake -DBIGINT_INSTRUMENTATION=ON); otherwise the macros below expand to nothing
+// and all statistics stay zero.
+//
+// Each instrumented call is filed under its operation and a bucket of its largest
+// operand size in chunks: bucket b holds sizes [2^(b-1), 2^b). Counts are inclusive:
+// the multiplications done by pow are also counted under mul, so rows do not add up.
+// Allocations and detaches come from my_vector's counters of the calling thread.
+namespace instrumentation {
+	using ull = std::uint64_t;
+
+	enum class operation {
+		add, sub, mul, div, mod,
+		bit_and, bit_or, bit_xor, shl, shr,
+		addmul, cmp, pow, to_string, parse,
+		count
+	};
+
+	constexpr size_t BUCKETS = 8 * sizeof(size_t) + 1;
+
+	struct op_stats {
+		ull calls;
+		ull cycles;			// time stamp counter ticks, or nanoseconds where there is none
+		ull allocations;	// my_vector heap allocations
+		ull allocated_bytes;
+		ull detaches;		// copy-on-write copies made by my_vector::make_unique_copy
+	};
+
+	bool enabled();
+	char const *name(operation op);
+	size_t bucket(size_t chunks);
+
+	op_stats stats(operation op, size_t bucket);
+	// totals over all buckets
+	op_stats stats(operation op);
+	void reset();
+
+	// one line per non-empty (operation, bucket) pair
+	void dump(std::ostream &out);
+
+	// records one call from construction to destruction
+	class scope {
+	public:
+		scope(operation op, size_t chunks);
+		~scope();
+
+		scope(scope const &) = delete;
+		scope &operator=(scope const &) = delete;
+
+	private:
+		operation op;
+		size_t chunks;
+		ull start_cycles;
+		my_vector::hook_counters start;
+	};
+}
+
+#ifdef BIGINT_INSTRUMENTATION
+#define BIGINT_INSTRUMENT(op, chunks) \
+	instrumentation::scope instrumentation_scope(instrumentation::operation::op, (chunks))
+#else
+#define BIGINT_INSTRUMENT(op, chunks) ((void)0)
+#endif
+
+#endif // OPTS_INSTRUMENTATION_H
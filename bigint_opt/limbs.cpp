@@ -0,0 +1,592 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "limbs.h"
+#include "ifma.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace limbs {
+	constexpr unsigned CHUNK_BITS = 32;
+
+	unsigned count_leading_zeros(uint x)
+	{
+#if defined(__GNUC__)
+		return (unsigned)__builtin_clz(x);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, x);
+		return CHUNK_BITS - 1 - (unsigned)index;
+#else
+		unsigned res = 0;
+		while (!(x & 0x80000000u)) {
+			x <<= 1;
+			++res;
+		}
+		return res;
+#endif
+	}
+
+	unsigned count_trailing_zeros(uint x)
+	{
+#if defined(__GNUC__)
+		return (unsigned)__builtin_ctz(x);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, x);
+		return (unsigned)index;
+#else
+		unsigned res = 0;
+		while (!(x & 1)) {
+			x >>= 1;
+			++res;
+		}
+		return res;
+#endif
+	}
+
+	unsigned popcount(uint x)
+	{
+#if defined(__GNUC__)
+		return (unsigned)__builtin_popcount(x);
+#elif defined(_MSC_VER)
+		return (unsigned)__popcnt(x);
+#else
+		unsigned res = 0;
+		for (; x != 0; x &= x - 1) {
+			++res;
+		}
+		return res;
+#endif
+	}
+
+	uint lshift(uint *r, uint const *a, size_t n, unsigned cnt)
+	{
+		uint out = a[n - 1] >> (CHUNK_BITS - cnt);
+		for (size_t i = n - 1; i != 0; --i) {
+			r[i] = (a[i] << cnt) | (a[i - 1] >> (CHUNK_BITS - cnt));
+		}
+		r[0] = a[0] << cnt;
+		return out;
+	}
+
+	uint rshift(uint *r, uint const *a, size_t n, unsigned cnt)
+	{
+		uint out = a[0] << (CHUNK_BITS - cnt);
+		for (size_t i = 0; i != n - 1; ++i) {
+			r[i] = (a[i] >> cnt) | (a[i + 1] << (CHUNK_BITS - cnt));
+		}
+		r[n - 1] = a[n - 1] >> cnt;
+		return out;
+	}
+
+	uint add(uint *r, uint const *a, size_t an, uint const *b, size_t bn)
+	{
+		uint carry = add_n(r, a, b, bn);
+		return add_1(r + bn, a + bn, an - bn, carry);
+	}
+
+	uint sub(uint *r, uint const *a, size_t an, uint const *b, size_t bn)
+	{
+		uint borrow = sub_n(r, a, b, bn);
+		return sub_1(r + bn, a + bn, an - bn, borrow);
+	}
+
+	uint sub_1(uint *r, uint const *a, size_t n, uint b)
+	{
+		size_t i = 0;
+		for (; i != n && b != 0; ++i) {
+			uint x = a[i];
+			r[i] = x - b;
+			b = (x < b) ? 1 : 0;
+		}
+		if (r != a) {
+			std::copy(a + i, a + n, r + i);
+		}
+		return b;
+	}
+
+	ull mul_2(uint *r, uint const *a, size_t n, ull b, ull c)
+	{
+		// a[i] b + carry < 2^96, so the carry after it stays below 2^64
+		ull b_low = (uint)b, b_high = b >> CHUNK_BITS;
+		ull carry = c;
+		for (size_t i = 0; i != n; ++i) {
+			ull x = a[i];
+			ull low = x * b_low + (uint)carry;
+			r[i] = (uint)low;
+			carry = x * b_high + (carry >> CHUNK_BITS) + (low >> CHUNK_BITS);
+		}
+		return carry;
+	}
+
+	uint submul_1(uint *r, uint const *a, size_t n, uint b)
+	{
+		ull borrow = 0;
+		for (size_t i = 0; i != n; ++i) {
+			ull prod = (ull)a[i] * b + borrow;
+			uint low = (uint)prod;
+			borrow = (prod >> CHUNK_BITS) + (r[i] < low);
+			r[i] -= low;
+		}
+		return (uint)borrow;
+	}
+
+	void mul_basecase(uint *r, uint const *a, size_t an, uint const *b, size_t bn)
+	{
+		r[an] = mul_1(r, a, an, b[0]);
+		for (size_t j = 1; j != bn; ++j) {
+			r[an + j] = addmul_1(r + j, a, an, b[j]);
+		}
+	}
+
+	// a Karatsuba step splits n chunks at low = n / 2, and the code below needs low >= 2;
+	// the tune program's run-time thresholds start at 8
+#ifndef TUNE_PROGRAM_BUILD
+	static_assert(KARATSUBA_MUL_THRESHOLD >= 4, "KARATSUBA_MUL_THRESHOLD must be at least 4");
+	static_assert(KARATSUBA_SQR_THRESHOLD >= 4, "KARATSUBA_SQR_THRESHOLD must be at least 4");
+#endif
+
+	static size_t karatsuba_scratch(size_t n, size_t threshold)
+	{
+		size_t res = 0;
+		while (n >= threshold) {
+			n = n - n / 2 + 1;
+			res += 4 * n;
+		}
+		return res;
+	}
+
+	static_assert(IFMA_MUL_LIMIT <= ifma::MUL_LIMIT, "IFMA_MUL_LIMIT is above what ifma::mul accepts");
+
+	// an >= bn, the sizes that ifma::mul takes over from the schoolbook and Karatsuba code
+	static bool use_ifma(size_t an, size_t bn)
+	{
+		return bn >= IFMA_MUL_THRESHOLD && an <= IFMA_MUL_LIMIT && ifma::active();
+	}
+
+	// r = a * b for two n-chunk operands, r has 2n chunks
+	static void karatsuba(uint *r, uint const *a, uint const *b, size_t n, uint *scratch)
+	{
+		if (use_ifma(n, n)) {
+			ifma::mul(r, a, n, b, n);
+			return;
+		}
+		if (n < KARATSUBA_MUL_THRESHOLD) {
+			mul_basecase(r, a, n, b, n);
+			return;
+		}
+
+		size_t low = n / 2, high = n - low;
+		karatsuba(r, a, b, low, scratch);
+		karatsuba(r + 2 * low, a + low, b + low, high, scratch);
+
+		// (a0 + a1)(b0 + b1) - a0 b0 - a1 b1
+		uint *a_sum = scratch;
+		uint *b_sum = a_sum + high + 1;
+		uint *middle = b_sum + high + 1;
+		a_sum[high] = add(a_sum, a + low, high, a, low);
+		b_sum[high] = add(b_sum, b + low, high, b, low);
+		karatsuba(middle, a_sum, b_sum, high + 1, middle + 2 * (high + 1));
+
+		size_t middle_size = 2 * (high + 1);
+		sub(middle, middle, middle_size, r, 2 * low);
+		sub(middle, middle, middle_size, r + 2 * low, 2 * high);
+		add(r + low, r + low, n + high, middle, middle_size);
+	}
+
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn)
+	{
+		if (an < bn) {
+			std::swap(a, b);
+			std::swap(an, bn);
+		}
+		if (use_ifma(an, bn)) {
+			ifma::mul(r, a, an, b, bn);
+			return;
+		}
+		if (bn < KARATSUBA_MUL_THRESHOLD) {
+			mul_basecase(r, a, an, b, bn);
+			return;
+		}
+		if (an == bn) {
+			std::vector<uint> scratch(karatsuba_scratch(an, KARATSUBA_MUL_THRESHOLD));
+			karatsuba(r, a, b, an, scratch.data());
+			return;
+		}
+
+		// unbalanced: multiply bn-sized slices of a by b
+		std::fill(r, r + an + bn, 0);
+		std::vector<uint> part(2 * bn);
+		for (size_t offset = 0; offset < an; offset += bn) {
+			size_t len = std::min(bn, an - offset);
+			mul(part.data(), a + offset, len, b, bn);
+			add(r + offset, r + offset, an + bn - offset, part.data(), len + bn);
+		}
+	}
+
+	void sqr_basecase(uint *r, uint const *a, size_t n)
+	{
+		// cross products a[i] * a[j], i < j, then doubled
+		std::fill(r, r + 2 * n, 0);
+		for (size_t i = 0; i + 1 < n; ++i) {
+			r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+		}
+		lshift(r, r, 2 * n, 1);
+
+		ull carry = 0;
+		for (size_t i = 0; i != n; ++i) {
+			ull square = (ull)a[i] * a[i];
+			carry += (ull)r[2 * i] + (uint)square;
+			r[2 * i] = (uint)carry;
+			carry >>= CHUNK_BITS;
+			carry += (ull)r[2 * i + 1] + (square >> CHUNK_BITS);
+			r[2 * i + 1] = (uint)carry;
+			carry >>= CHUNK_BITS;
+		}
+	}
+
+	static void karatsuba_sqr(uint *r, uint const *a, size_t n, uint *scratch)
+	{
+		if (use_ifma(n, n)) {
+			ifma::mul(r, a, n, a, n);
+			return;
+		}
+		if (n < KARATSUBA_SQR_THRESHOLD) {
+			sqr_basecase(r, a, n);
+			return;
+		}
+
+		size_t low = n / 2, high = n - low;
+		karatsuba_sqr(r, a, low, scratch);
+		karatsuba_sqr(r + 2 * low, a + low, high, scratch);
+
+		// (a0 + a1)^2 - a0^2 - a1^2
+		uint *a_sum = scratch;
+		uint *middle = a_sum + 2 * (high + 1);
+		a_sum[high] = add(a_sum, a + low, high, a, low);
+		karatsuba_sqr(middle, a_sum, high + 1, middle + 2 * (high + 1));
+
+		size_t middle_size = 2 * (high + 1);
+		sub(middle, middle, middle_size, r, 2 * low);
+		sub(middle, middle, middle_size, r + 2 * low, 2 * high);
+		add(r + low, r + low, n + high, middle, middle_size);
+	}
+
+	void sqr(uint *r, uint const *a, size_t n)
+	{
+		if (use_ifma(n, n)) {
+			ifma::mul(r, a, n, a, n);
+			return;
+		}
+		if (n < KARATSUBA_SQR_THRESHOLD) {
+			sqr_basecase(r, a, n);
+			return;
+		}
+		std::vector<uint> scratch(karatsuba_scratch(n, KARATSUBA_SQR_THRESHOLD));
+		karatsuba_sqr(r, a, n, scratch.data());
+	}
+
+	// karatsuba with the three subproducts as tasks, each with its own scratch
+	static void karatsuba_parallel(uint *r, uint const *a, uint const *b, size_t n, size_t threads)
+	{
+		if (threads < 2 || n < PARALLEL_MUL_THRESHOLD) {
+			std::vector<uint> scratch(karatsuba_scratch(n, KARATSUBA_MUL_THRESHOLD));
+			karatsuba(r, a, b, n, scratch.data());
+			return;
+		}
+
+		size_t low = n / 2, high = n - low;
+		size_t share = (threads + 2) / 3;
+		std::vector<uint> a_sum(high + 1), b_sum(high + 1), middle(2 * (high + 1));
+		a_sum[high] = add(a_sum.data(), a + low, high, a, low);
+		b_sum[high] = add(b_sum.data(), b + low, high, b, low);
+
+		parallel::task_group group;
+		group.run([=] { karatsuba_parallel(r, a, b, low, share); });
+		group.run([=] { karatsuba_parallel(r + 2 * low, a + low, b + low, high, share); });
+		karatsuba_parallel(middle.data(), a_sum.data(), b_sum.data(), high + 1, share);
+		group.wait();
+
+		sub(middle.data(), middle.data(), middle.size(), r, 2 * low);
+		sub(middle.data(), middle.data(), middle.size(), r + 2 * low, 2 * high);
+		add(r + low, r + low, n + high, middle.data(), middle.size());
+	}
+
+	static void karatsuba_sqr_parallel(uint *r, uint const *a, size_t n, size_t threads)
+	{
+		if (threads < 2 || n < PARALLEL_MUL_THRESHOLD) {
+			std::vector<uint> scratch(karatsuba_scratch(n, KARATSUBA_SQR_THRESHOLD));
+			karatsuba_sqr(r, a, n, scratch.data());
+			return;
+		}
+
+		size_t low = n / 2, high = n - low;
+		size_t share = (threads + 2) / 3;
+		std::vector<uint> a_sum(high + 1), middle(2 * (high + 1));
+		a_sum[high] = add(a_sum.data(), a + low, high, a, low);
+
+		parallel::task_group group;
+		group.run([=] { karatsuba_sqr_parallel(r, a, low, share); });
+		group.run([=] { karatsuba_sqr_parallel(r + 2 * low, a + low, high, share); });
+		karatsuba_sqr_parallel(middle.data(), a_sum.data(), high + 1, share);
+		group.wait();
+
+		sub(middle.data(), middle.data(), middle.size(), r, 2 * low);
+		sub(middle.data(), middle.data(), middle.size(), r + 2 * low, 2 * high);
+		add(r + low, r + low, n + high, middle.data(), middle.size());
+	}
+
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn, size_t threads)
+	{
+		if (an < bn) {
+			std::swap(a, b);
+			std::swap(an, bn);
+		}
+		if (threads < 2 || bn < PARALLEL_MUL_THRESHOLD) {
+			mul(r, a, an, b, bn);
+			return;
+		}
+		if (an == bn) {
+			karatsuba_parallel(r, a, b, an, threads);
+			return;
+		}
+
+		// unbalanced: up to threads slices of a, each multiplied into its own buffer
+		size_t slices = std::min(threads, (an + bn - 1) / bn);
+		size_t len = (an + slices - 1) / slices;
+		slices = (an + len - 1) / len;
+		size_t share = (threads + slices - 1) / slices;
+		std::vector<std::vector<uint>> parts(slices);
+		parallel::task_group group;
+		for (size_t i = 0; i != slices; ++i) {
+			size_t offset = i * len, part_len = std::min(len, an - offset);
+			parts[i].resize(part_len + bn);
+			uint *part = parts[i].data();
+			group.run([=] { mul(part, a + offset, part_len, b, bn, share); });
+		}
+		group.wait();
+
+		std::fill(r, r + an + bn, 0);
+		for (size_t i = 0; i != slices; ++i) {
+			size_t offset = i * len;
+			add(r + offset, r + offset, an + bn - offset, parts[i].data(), parts[i].size());
+		}
+	}
+
+	void sqr(uint *r, uint const *a, size_t n, size_t threads)
+	{
+		if (threads < 2 || n < PARALLEL_MUL_THRESHOLD) {
+			sqr(r, a, n);
+			return;
+		}
+		karatsuba_sqr_parallel(r, a, n, threads);
+	}
+
+	uint inverse_mod_base(uint a)
+	{
+		// Newton iteration, every step doubles the number of correct low bits
+		uint x = a;
+		for (int i = 0; i != 4; ++i) {
+			x *= 2 - a * x;
+		}
+		return x;
+	}
+
+	void mont_mul(uint *r, uint const *a, uint const *b, uint const *m, size_t n, uint m_inv, uint *scratch)
+	{
+		// coarsely integrated operand scanning: one reduction step per chunk of b
+		uint *t = scratch;
+		std::fill(t, t + n + 2, 0);
+		for (size_t i = 0; i != n; ++i) {
+			ull top = (ull)t[n] + addmul_1(t, a, n, b[i]);
+			t[n] = (uint)top;
+			t[n + 1] = (uint)(top >> CHUNK_BITS);
+
+			uint q = t[0] * m_inv;
+			top = (ull)t[n] + addmul_1(t, m, n, q);
+			t[n] = (uint)top;
+			t[n + 1] += (uint)(top >> CHUNK_BITS);
+
+			std::copy(t + 1, t + n + 2, t);
+			t[n + 1] = 0;
+		}
+		if (t[n] != 0 || cmp(t, m, n) >= 0) {
+			sub_n(t, t, m, n);
+		}
+		std::copy(t, t + n, r);
+	}
+
+	uint mod_1(uint const *a, size_t n, divisor_1 const &d)
+	{
+		if (n == 0) {
+			return 0;
+		}
+		uint rem = shifted(0, a[n - 1], d.shift);
+		for (size_t i = n; i--;) {
+			div_step(rem, shifted(a[i], (i != 0) ? a[i - 1] : 0, d.shift), d, rem);
+		}
+		return rem >> d.shift;
+	}
+
+	// blocks of divisors small enough for their remainders to stay in registers
+	constexpr size_t MULTI_MOD_BLOCK = 8;
+	// setting up a reciprocal costs about one division, overlapped hardware
+	// divisions are cheaper than that for a couple of chunks
+	constexpr size_t MULTI_MOD_RECIPROCAL_SIZE = 4;
+
+	void multi_mod_1(uint *r, uint const *a, size_t n, uint const *d, size_t count)
+	{
+		constexpr size_t BLOCK = MULTI_MOD_BLOCK;
+		if (n < MULTI_MOD_RECIPROCAL_SIZE) {
+			for (size_t from = 0; from < count; from += BLOCK) {
+				size_t size = std::min(BLOCK, count - from);
+				ull rem[BLOCK] = {};
+				for (size_t i = n; i--;) {
+					for (size_t j = 0; j != size; ++j) {
+						rem[j] = ((rem[j] << CHUNK_BITS) | a[i]) % d[from + j];
+					}
+				}
+				for (size_t j = 0; j != size; ++j) {
+					r[from + j] = (uint)rem[j];
+				}
+			}
+			return;
+		}
+
+		std::vector<divisor_1> divisors(d, d + count);
+		for (size_t from = 0; from < count; from += BLOCK) {
+			size_t size = std::min(BLOCK, count - from);
+			divisor_1 const *block = divisors.data() + from;
+			uint rem[BLOCK];
+			for (size_t j = 0; j != size; ++j) {
+				rem[j] = shifted(0, a[n - 1], block[j].shift);
+			}
+			for (size_t i = n; i--;) {
+				uint next = (i != 0) ? a[i - 1] : 0;
+				for (size_t j = 0; j != size; ++j) {
+					div_step(rem[j], shifted(a[i], next, block[j].shift), block[j], rem[j]);
+				}
+			}
+			for (size_t j = 0; j != size; ++j) {
+				r[from + j] = rem[j] >> block[j].shift;
+			}
+		}
+	}
+
+	void divrem(uint *q, uint *r, uint const *a, size_t an, uint const *d, size_t dn)
+	{
+		// normalize so that the top bit of the divisor is set
+		unsigned shift = count_leading_zeros(d[dn - 1]);
+		std::vector<uint> u(an + 1), v(d, d + dn);
+		if (shift != 0) {
+			lshift(v.data(), d, dn, shift);
+			u[an] = lshift(u.data(), a, an, shift);
+		}
+		else {
+			std::copy(a, a + an, u.begin());
+		}
+
+		ull v_top = v[dn - 1], v_next = v[dn - 2];
+		for (size_t j = an - dn + 1; j--;) {
+			ull num = ((ull)u[j + dn] << CHUNK_BITS) | u[j + dn - 1];
+			ull q_hat = num / v_top, r_hat = num % v_top;
+			while (q_hat > UINT32_MAX
+				|| q_hat * v_next > ((r_hat << CHUNK_BITS) | u[j + dn - 2])) {
+				--q_hat;
+				r_hat += v_top;
+				if (r_hat > UINT32_MAX) {
+					break;
+				}
+			}
+
+			uint borrow = submul_1(u.data() + j, v.data(), dn, (uint)q_hat);
+			bool negative = u[j + dn] < borrow;
+			u[j + dn] -= borrow;
+			if (negative) {
+				--q_hat;
+				u[j + dn] += add_n(u.data() + j, u.data() + j, v.data(), dn);
+			}
+			q[j] = (uint)q_hat;
+		}
+
+		if (shift != 0) {
+			rshift(r, u.data(), dn, shift);
+		}
+		else {
+			std::copy(u.begin(), u.begin() + dn, r);
+		}
+	}
+
+	// one step of Hensel division by a single chunk: q = (x - borrow) d^-1 mod 2^32,
+	// borrow becomes what the next chunk owes once q d is taken off
+	static uint hensel_step_1(uint x, uint d, uint inv, uint &borrow)
+	{
+		uint s = x - borrow;
+		uint q = s * inv;
+		borrow = ((s > x) ? 1 : 0) + (uint)(((ull)q * d) >> CHUNK_BITS);
+		return q;
+	}
+
+	void divexact(uint *q, uint const *a, size_t an, uint const *d, size_t dn)
+	{
+		size_t qn = an - dn + 1;
+		uint inv = inverse_mod_base(d[0]);
+		if (dn == 1) {
+			uint borrow = 0;
+			for (size_t i = 0; i != qn; ++i) {
+				q[i] = hensel_step_1(a[i], d[0], inv, borrow);
+			}
+			return;
+		}
+
+		// rows are cut off at chunk qn, the chunks of a above it are never needed
+		std::vector<uint> r(a, a + qn);
+		for (size_t i = 0; i != qn; ++i) {
+			uint qi = r[i] * inv;
+			size_t k = std::min(dn, qn - i);
+			uint borrow = submul_1(r.data() + i, d, k, qi);
+			sub_1(r.data() + i + k, r.data() + i + k, qn - i - k, borrow);
+			q[i] = qi;
+		}
+	}
+
+	bool divisible(uint const *a, size_t an, uint const *d, size_t dn)
+	{
+		uint inv = inverse_mod_base(d[0]);
+		if (dn == 1) {
+			// what is left is -borrow 2^(32 an)
+			uint borrow = 0;
+			for (size_t i = 0; i != an; ++i) {
+				hensel_step_1(a[i], d[0], inv, borrow);
+			}
+			return borrow == 0;
+		}
+
+		size_t qn = an - dn + 1;
+		if (std::min(qn, dn) >= KARATSUBA_MUL_THRESHOLD) {
+			// the triangle of divexact and a subquadratic product back are cheaper
+			// than the full reduction; a = q d exactly when d divides a
+			std::vector<uint> q(qn), p(qn + dn);
+			divexact(q.data(), a, an, d, dn);
+			mul(p.data(), q.data(), qn, d, dn);
+			return p[an] == 0 && cmp(p.data(), a, an) == 0;
+		}
+
+		// after step i, r = a - (q[0, i]) d with its low i + 1 chunks zero; it
+		// only decreases, so once it is negative d cannot divide a
+		std::vector<uint> r(a, a + an);
+		for (size_t i = 0; i != qn; ++i) {
+			uint borrow = submul_1(r.data() + i, d, dn, r[i] * inv);
+			if (sub_1(r.data() + i + dn, r.data() + i + dn, an - i - dn, borrow) != 0) {
+				return false;
+			}
+		}
+		return normalized_size(r.data() + qn, dn - 1) == 0;
+	}
+}
@@ -0,0 +1,267 @@
+#ifndef OPTS_LIMBS_H
+#define OPTS_LIMBS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tuning.h"
+
+// Low-level kernels over little-endian arrays of 32-bit chunks.
+// Output arrays may alias an input only where noted.
+namespace limbs {
+	using uint = std::uint32_t;
+	using ull = std::uint64_t;
+
+	// single-chunk steps, shared by the array kernels below and fixed_big_integer;
+	// constexpr so that fixed_big_integer arithmetic works in constant expressions
+
+	// a + b + carry, carry in and out is 0 or 1
+	constexpr uint add_with_carry(uint a, uint b, uint &carry)
+	{
+		ull sum = (ull)a + b + carry;
+		carry = (uint)(sum >> 32);
+		return (uint)sum;
+	}
+
+	// a - b - borrow, borrow in and out is 0 or 1
+	constexpr uint sub_with_borrow(uint a, uint b, uint &borrow)
+	{
+		ull diff = (ull)a - b - borrow;
+		borrow = (uint)(diff >> 32) & 1;
+		return (uint)diff;
+	}
+
+	// a * b + c + carry, the high chunk goes to carry
+	constexpr uint mul_add(uint a, uint b, uint c, uint &carry)
+	{
+		ull prod = (ull)a * b + c + carry;
+		carry = (uint)(prod >> 32);
+		return (uint)prod;
+	}
+
+	// number of bits up to the highest set bit, 0 for x == 0
+	constexpr unsigned bit_length(uint x)
+	{
+#if defined(__GNUC__)
+		return (x == 0) ? 0 : 32 - (unsigned)__builtin_clz(x);
+#else
+		unsigned res = 0;
+		for (; x != 0; x >>= 1) {
+			++res;
+		}
+		return res;
+#endif
+	}
+
+	// the array kernels that fixed_big_integer needs are defined here, constexpr
+	// as well; the rest are in limbs.cpp
+
+	// size without leading zero chunks (0 for an all-zero array)
+	constexpr size_t normalized_size(uint const *a, size_t n)
+	{
+		while (n != 0 && a[n - 1] == 0) {
+			--n;
+		}
+		return n;
+	}
+
+	// -1, 0, 1 comparing two arrays of the same length
+	constexpr int cmp(uint const *a, uint const *b, size_t n)
+	{
+		while (n--) {
+			if (a[n] != b[n]) {
+				return (a[n] > b[n]) ? 1 : -1;
+			}
+		}
+		return 0;
+	}
+
+	// number of zero bits above the highest set bit, x != 0
+	unsigned count_leading_zeros(uint x);
+	// number of zero bits below the lowest set bit, x != 0
+	unsigned count_trailing_zeros(uint x);
+	unsigned popcount(uint x);
+
+	// r = a << cnt, 0 < cnt < 32, returns the bits shifted out; r may alias a
+	uint lshift(uint *r, uint const *a, size_t n, unsigned cnt);
+	// r = a >> cnt, 0 < cnt < 32, returns the bits shifted out (in the high end); r may alias a
+	uint rshift(uint *r, uint const *a, size_t n, unsigned cnt);
+
+	// r = a + b, returns carry; r may alias a or b
+	constexpr uint add_n(uint *r, uint const *a, uint const *b, size_t n)
+	{
+		uint carry = 0;
+		for (size_t i = 0; i != n; ++i) {
+			r[i] = add_with_carry(a[i], b[i], carry);
+		}
+		return carry;
+	}
+
+	// r = a + b for a single chunk b, returns carry; r may alias a (then only the carry chain is touched)
+	constexpr uint add_1(uint *r, uint const *a, size_t n, uint b)
+	{
+		size_t i = 0;
+		for (; i != n && b != 0; ++i) {
+			r[i] = a[i] + b;
+			b = (r[i] < b) ? 1 : 0;
+		}
+		if (r != a) {
+			for (; i != n; ++i) {
+				r[i] = a[i];
+			}
+		}
+		return b;
+	}
+
+	// r = a + b, an >= bn, r has an chunks; r may alias a
+	uint add(uint *r, uint const *a, size_t an, uint const *b, size_t bn);
+
+	// r = a - b, returns borrow; r may alias a or b
+	constexpr uint sub_n(uint *r, uint const *a, uint const *b, size_t n)
+	{
+		uint borrow = 0;
+		for (size_t i = 0; i != n; ++i) {
+			r[i] = sub_with_borrow(a[i], b[i], borrow);
+		}
+		return borrow;
+	}
+
+	// r = a - b, an >= bn, r has an chunks; r may alias a
+	uint sub(uint *r, uint const *a, size_t an, uint const *b, size_t bn);
+	// r = a - b for a single chunk b, returns borrow; r may alias a
+	uint sub_1(uint *r, uint const *a, size_t n, uint b);
+
+	// r = a * b, returns the high chunk; r may alias a
+	constexpr uint mul_1(uint *r, uint const *a, size_t n, uint b)
+	{
+		uint carry = 0;
+		for (size_t i = 0; i != n; ++i) {
+			r[i] = mul_add(a[i], b, 0, carry);
+		}
+		return carry;
+	}
+
+	// r += a * b, returns the high chunk
+	constexpr uint addmul_1(uint *r, uint const *a, size_t n, uint b)
+	{
+		uint carry = 0;
+		for (size_t i = 0; i != n; ++i) {
+			r[i] = mul_add(a[i], b, r[i], carry);
+		}
+		return carry;
+	}
+
+	// r -= a * b, returns the borrow chunk
+	uint submul_1(uint *r, uint const *a, size_t n, uint b);
+	// r = a * b + c for two-chunk b and c, returns the two chunks above r; r may alias a
+	ull mul_2(uint *r, uint const *a, size_t n, ull b, ull c);
+
+	// r = a * b, r has an + bn chunks and does not alias a or b
+	void mul_basecase(uint *r, uint const *a, size_t an, uint const *b, size_t bn);
+	// as mul_basecase, switching to Karatsuba for large operands
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn);
+
+	// r = a * a, r has 2n chunks and does not alias a
+	void sqr_basecase(uint *r, uint const *a, size_t n);
+	void sqr(uint *r, uint const *a, size_t n);
+
+	// mul and sqr on up to threads threads (see parallel.h): the top Karatsuba
+	// levels run their three half-size products as tasks while the operands are
+	// at least PARALLEL_MUL_THRESHOLD chunks, the rest is sequential
+	void mul(uint *r, uint const *a, size_t an, uint const *b, size_t bn, size_t threads);
+	void sqr(uint *r, uint const *a, size_t n, size_t threads);
+
+	// a^-1 mod 2^32, a odd
+	uint inverse_mod_base(uint a);
+	// Montgomery product r = a * b / 2^(32 n) mod m, m odd, a, b < m
+	// m_inv = -m^-1 mod 2^32, scratch has n + 2 chunks, r may alias a or b
+	void mont_mul(uint *r, uint const *a, uint const *b, uint const *m, size_t n, uint m_inv, uint *scratch);
+
+	// a single-chunk divisor d != 0 with a precomputed reciprocal, so that dividing
+	// by it takes multiplications only (Moller and Granlund, "Improved division
+	// by invariant integers")
+	struct divisor_1 {
+		uint d;
+		// d << shift has the top bit set
+		unsigned shift;
+		uint normalized;
+		// floor((2^64 - 1) / normalized) - 2^32
+		uint reciprocal;
+
+		constexpr explicit divisor_1(uint d)
+			: d(d),
+			shift(32 - bit_length(d)),
+			normalized(d << shift),
+			reciprocal((uint)(~(ull)0 / normalized))
+		{
+		}
+	};
+
+	// the chunk at hi of (hi lo) << shift, 0 <= shift < 32
+	constexpr uint shifted(uint hi, uint lo, unsigned shift)
+	{
+		return (uint)((((ull)hi << 32) | lo) >> (32 - shift));
+	}
+
+	// (u1 u0) / d.normalized for u1 < d.normalized, the remainder goes to r
+	constexpr uint div_step(uint u1, uint u0, divisor_1 const &d, uint &r)
+	{
+		// the quotient estimate is at most one too large or too small
+		ull q = (ull)d.reciprocal * u1 + (((ull)(u1 + 1) << 32) | u0);
+		uint q_high = (uint)(q >> 32), q_low = (uint)q;
+		uint rem = u0 - q_high * d.normalized;
+		if (rem > q_low) {
+			--q_high;
+			rem += d.normalized;
+		}
+		if (rem >= d.normalized) {
+			++q_high;
+			rem -= d.normalized;
+		}
+		r = rem;
+		return q_high;
+	}
+
+	// q = a / d, returns a % d; q has n chunks and may alias a
+	constexpr uint divrem_1(uint *q, uint const *a, size_t n, divisor_1 const &d)
+	{
+		// a << shift divided by d << shift, the shift applied chunk by chunk
+		if (n == 0) {
+			return 0;
+		}
+		uint rem = shifted(0, a[n - 1], d.shift);
+		for (size_t i = n; i--;) {
+			uint u0 = shifted(a[i], (i != 0) ? a[i - 1] : 0, d.shift);
+			q[i] = div_step(rem, u0, d, rem);
+		}
+		return rem >> d.shift;
+	}
+
+	constexpr uint divrem_1(uint *q, uint const *a, size_t n, uint d)
+	{
+		return divrem_1(q, a, n, divisor_1(d));
+	}
+
+	// a % d
+	uint mod_1(uint const *a, size_t n, divisor_1 const &d);
+	// r[j] = a % d[j] for count single-chunk divisors in one pass over a;
+	// the divisions for different divisors are independent and overlap
+	void multi_mod_1(uint *r, uint const *a, size_t n, uint const *d, size_t count);
+	// q = a / d, r = a % d (Knuth, algorithm D)
+	// an >= dn >= 2, d[dn - 1] != 0, q has an - dn + 1 chunks, r has dn chunks
+	void divrem(uint *q, uint *r, uint const *a, size_t an, uint const *d, size_t dn);
+
+	// q = a / d for a d that divides a, by Hensel division from the low end
+	// (Jebelean, "An exact division algorithm"): q[i] = r[i] d^-1 mod 2^32, and
+	// everything is computed modulo 2^(32 (an - dn + 1)), so there are no trial
+	// quotients and the rows shorten towards the top. d odd, an >= dn, d[dn - 1] != 0,
+	// q has an - dn + 1 chunks and does not alias a; the result is garbage if d
+	// does not divide a
+	void divexact(uint *q, uint const *a, size_t an, uint const *d, size_t dn);
+	// whether d divides a, d odd, an >= dn, d[dn - 1] != 0: the same reduction
+	// over all of a without keeping the quotient, or for large operands the
+	// quotient of divexact multiplied back
+	bool divisible(uint const *a, size_t an, uint const *d, size_t dn);
+}
+
+#endif // OPTS_LIMBS_H
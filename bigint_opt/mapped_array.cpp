@@ -0,0 +1,252 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "mapped_array.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+using std::uint8_t;
+
+namespace {
+	constexpr char MAGIC[8] = {'B', 'I', 'G', 'A', 'R', 'R', '0', '1'};
+	// magic and count
+	constexpr size_t HEADER_BYTES = 16;
+	constexpr size_t OFFSET_BYTES = 8;
+	constexpr size_t CHUNK_BYTES = sizeof(uint);
+
+	bool little_endian()
+	{
+		uint one = 1;
+		uint8_t first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	ull load_u64(uint8_t const *p)
+	{
+		ull res = 0;
+		for (size_t k = OFFSET_BYTES; k--;) {
+			res = (res << 8) | p[k];
+		}
+		return res;
+	}
+
+	void store_u64(uint8_t *p, ull value)
+	{
+		for (size_t k = 0; k != OFFSET_BYTES; ++k) {
+			p[k] = (uint8_t)(value >> (8 * k));
+		}
+	}
+
+	// offsets and sign bytes; keeps the chunks 8-byte aligned
+	size_t index_size(size_t count)
+	{
+		return OFFSET_BYTES * (count + 1) + (count + 7) / 8 * 8;
+	}
+
+	[[noreturn]] void corrupt()
+	{
+		throw std::runtime_error("corrupt big integer array");
+	}
+}
+
+struct mapped_big_integer_array::file_view {
+	uint8_t const *bytes;
+	size_t size;
+
+#ifdef HAVE_MMAP
+	explicit file_view(std::string const &path)
+		: bytes(nullptr), size(0)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("cannot open " + path);
+		}
+		struct stat info;
+		if (::fstat(fd, &info) != 0) {
+			::close(fd);
+			throw std::runtime_error("cannot open " + path);
+		}
+		size = (size_t)info.st_size;
+		if (size != 0) {
+			void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("cannot map " + path);
+			}
+			bytes = static_cast<uint8_t const *>(map);
+		}
+		// the mapping outlives the descriptor
+		::close(fd);
+	}
+
+	~file_view()
+	{
+		if (size != 0) {
+			::munmap(const_cast<uint8_t *>(bytes), size);
+		}
+	}
+#else
+	// whole words, so that the chunks are aligned as in a mapping
+	std::vector<ull> buffer;
+
+	explicit file_view(std::string const &path)
+		: bytes(nullptr), size(0)
+	{
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if (!in) {
+			throw std::runtime_error("cannot open " + path);
+		}
+		size = (size_t)in.tellg();
+		buffer.resize((size + sizeof(ull) - 1) / sizeof(ull));
+		in.seekg(0);
+		if (!in.read(reinterpret_cast<char *>(buffer.data()), (std::streamsize)size)) {
+			throw std::runtime_error("cannot read " + path);
+		}
+		bytes = reinterpret_cast<uint8_t const *>(buffer.data());
+	}
+#endif
+
+	file_view(file_view const &) = delete;
+	file_view &operator=(file_view const &) = delete;
+};
+
+void write_big_integer_array(std::string const &path, big_integer const *values, size_t count)
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("cannot open " + path);
+	}
+
+	std::vector<uint8_t> index(HEADER_BYTES + index_size(count), 0);
+	std::memcpy(index.data(), MAGIC, sizeof(MAGIC));
+	store_u64(index.data() + sizeof(MAGIC), count);
+	uint8_t *offsets = index.data() + HEADER_BYTES;
+	uint8_t *signs = offsets + OFFSET_BYTES * (count + 1);
+	ull offset = 0;
+	for (size_t i = 0; i != count; ++i) {
+		store_u64(offsets + OFFSET_BYTES * i, offset);
+		signs[i] = (values[i].signum < 0) ? 1 : 0;
+		offset += (values[i].signum == 0) ? 0 : values[i].get_data_size();
+	}
+	store_u64(offsets + OFFSET_BYTES * count, offset);
+	out.write(reinterpret_cast<char const *>(index.data()), (std::streamsize)index.size());
+
+	// little-endian chunks, whatever the machine
+	std::vector<uint8_t> bytes;
+	for (size_t i = 0; i != count; ++i) {
+		if (values[i].signum != 0) {
+			bytes.resize(export_size(values[i], CHUNK_BYTES) * CHUNK_BYTES);
+			export_words(bytes.data(), -1, CHUNK_BYTES, -1, values[i]);
+			out.write(reinterpret_cast<char const *>(bytes.data()), (std::streamsize)bytes.size());
+		}
+	}
+	if (!out.flush()) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+void write_big_integer_array(std::string const &path, std::vector<big_integer> const &values)
+{
+	write_big_integer_array(path, values.data(), values.size());
+}
+
+mapped_big_integer_array::mapped_big_integer_array(std::string const &path)
+	: file(std::make_shared<file_view>(path))
+{
+	uint8_t const *bytes = file->bytes;
+	size_t size = file->size;
+	if (size < HEADER_BYTES || std::memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0) {
+		throw std::runtime_error("not a big integer array: " + path);
+	}
+
+	// the index has at least 9 bytes per number, which bounds count before
+	// anything is multiplied by it
+	ull n = load_u64(bytes + sizeof(MAGIC));
+	if (n > (size - HEADER_BYTES) / (OFFSET_BYTES + 1) || HEADER_BYTES + index_size((size_t)n) > size) {
+		corrupt();
+	}
+	count = (size_t)n;
+	offsets = bytes + HEADER_BYTES;
+	signs = offsets + OFFSET_BYTES * (count + 1);
+	size_t data_start = HEADER_BYTES + index_size(count);
+	total = load_u64(offsets + OFFSET_BYTES * count);
+	if (total > (size - data_start) / CHUNK_BYTES) {
+		corrupt();
+	}
+	data = reinterpret_cast<uint const *>(bytes + data_start);
+}
+
+void mapped_big_integer_array::range(size_t i, ull &from, ull &to) const
+{
+	if (i >= count) {
+		throw std::runtime_error("big integer array index out of range");
+	}
+	from = load_u64(offsets + OFFSET_BYTES * i);
+	to = load_u64(offsets + OFFSET_BYTES * (i + 1));
+	if (from > to || to > total || signs[i] > 1) {
+		corrupt();
+	}
+	// numbers have no leading zero chunks
+	if (from != to) {
+		uint8_t const *top = reinterpret_cast<uint8_t const *>(data + to - 1);
+		if ((top[0] | top[1] | top[2] | top[3]) == 0) {
+			corrupt();
+		}
+	}
+}
+
+big_integer mapped_big_integer_array::operator[](size_t i) const
+{
+	ull from, to;
+	range(i, from, to);
+	big_integer res;
+	if (from == to) {
+		return res;
+	}
+	size_t n = (size_t)(to - from);
+	if (little_endian()) {
+		serial_detail::assign(res, my_vector::adopt(file, data + from, n), signs[i] == 1);
+	}
+	else {
+		res = import_words(data + from, n, -1, CHUNK_BYTES, -1);
+		if (signs[i] == 1) {
+			res = -res;
+		}
+	}
+	return res;
+}
+
+mapped_big_integer_array::uint const *mapped_big_integer_array::chunks(size_t i) const
+{
+	ull from, to;
+	range(i, from, to);
+	return data + from;
+}
+
+size_t mapped_big_integer_array::chunk_count(size_t i) const
+{
+	ull from, to;
+	range(i, from, to);
+	return (size_t)(to - from);
+}
+
+int mapped_big_integer_array::signum(size_t i) const
+{
+	ull from, to;
+	range(i, from, to);
+	return (from == to) ? 0 : (signs[i] == 1) ? -1 : 1;
+}
@@ -0,0 +1,63 @@
+#ifndef BIG_INTEGER_MAPPED_ARRAY_H
+#define BIG_INTEGER_MAPPED_ARRAY_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Files of many big integers that open in O(1): the chunks of all numbers
+// lie one after another and an index of offsets says where each begins.
+// Layout, all little-endian:
+//   8 bytes  magic "BIGARR01"
+//   8 bytes  count
+//   8 bytes  per number and one more: offset of its first chunk, the last one
+//            is the total number of chunks
+//   1 byte   per number: 1 if negative, else 0; zero bytes up to a multiple of 8
+//   4 bytes  per chunk, from the least significant one of every number
+// A number with no chunks is 0.
+
+// throws if the file cannot be written
+void write_big_integer_array(std::string const &path, big_integer const *values, size_t count);
+void write_big_integer_array(std::string const &path, std::vector<big_integer> const &values);
+
+// A read-only view of such a file, mapped into memory where the system has
+// mmap (read in whole elsewhere). Numbers are only checked when accessed; a
+// bad file header or a bad number throws.
+class mapped_big_integer_array {
+public:
+	using uint = std::uint32_t;
+
+	explicit mapped_big_integer_array(std::string const &path);
+
+	size_t size() const {
+		return count;
+	}
+
+	// number i using the mapped chunks in place, the first change to it
+	// copies them; it stays valid after the array is gone
+	big_integer operator[](size_t i) const;
+
+	// the chunks of number i as stored (little-endian) and its sign, -1, 0 or 1
+	uint const *chunks(size_t i) const;
+	size_t chunk_count(size_t i) const;
+	int signum(size_t i) const;
+
+private:
+	struct file_view;
+
+	// start and end chunk of number i, checked
+	void range(size_t i, std::uint64_t &from, std::uint64_t &to) const;
+
+	std::shared_ptr<file_view const> file;
+	size_t count;
+	std::uint8_t const *offsets;
+	std::uint8_t const *signs;
+	uint const *data;
+	std::uint64_t total;
+};
+
+#endif // BIG_INTEGER_MAPPED_ARRAY_H
@@ -0,0 +1,144 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "multi_mod.h"
+#include "fixed_big_integer.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+
+namespace {
+	using tree_levels = std::vector<std::vector<big_integer>>;
+
+	// levels[0] are the leaves, levels[l + 1][i] = levels[l][2 i] * levels[l][2 i + 1]
+	// (the last one alone when levels[l] has odd size); node i of level l covers
+	// leaves [i 2^l, (i + 1) 2^l). Levels stop at a single node or once the first
+	// node has more than limit chunks, larger products are not needed for a
+	// number of limit chunks.
+	tree_levels product_tree(std::vector<big_integer> leaves, size_t limit)
+	{
+		tree_levels levels(1, std::move(leaves));
+		while (levels.back().size() > 1 && levels.back()[0].get_data_size() <= limit) {
+			std::vector<big_integer> const &below = levels.back();
+			std::vector<big_integer> level;
+			for (size_t i = 0; i < below.size(); i += 2) {
+				level.push_back((i + 1 < below.size()) ? below[i] * below[i + 1] : below[i]);
+			}
+			levels.push_back(std::move(level));
+		}
+		return levels;
+	}
+
+	// x % node for the nodes of one level, each from the remainder of its parent
+	std::vector<big_integer> remainders(big_integer const &x, tree_levels const &levels, size_t level)
+	{
+		std::vector<big_integer> rems;
+		for (big_integer const &node : levels.back()) {
+			rems.push_back(x % node);
+		}
+		for (size_t l = levels.size() - 1; l-- > level;) {
+			std::vector<big_integer> next(levels[l].size());
+			for (size_t i = 0; i != next.size(); ++i) {
+				next[i] = rems[i / 2] % levels[l][i];
+			}
+			rems = std::move(next);
+		}
+		return rems;
+	}
+
+	std::vector<uint> magnitude(big_integer const &x)
+	{
+		std::vector<uint> res(x.get_data_size());
+		for (size_t i = 0; i != res.size(); ++i) {
+			res[i] = x.get_chunk(i);
+		}
+		return res;
+	}
+}
+
+std::vector<uint> multi_mod(big_integer const &x, std::vector<uint> const &moduli)
+{
+	// products of consecutive moduli that fit a chunk, one remainder for each
+	std::vector<uint> groups;
+	std::vector<size_t> group_end;
+	ull product = 1;
+	for (size_t i = 0; i != moduli.size(); ++i) {
+		if (moduli[i] == 0) {
+			throw std::runtime_error("division by 0");
+		}
+		if (product * moduli[i] > UINT32_MAX) {
+			groups.push_back((uint)product);
+			group_end.push_back(i);
+			product = 1;
+		}
+		product *= moduli[i];
+	}
+	if (!moduli.empty()) {
+		groups.push_back((uint)product);
+		group_end.push_back(moduli.size());
+	}
+
+	bool negative = x < 0;
+	std::vector<uint> group_rems(groups.size());
+	std::vector<uint> a = magnitude(x);
+	if (a.size() < MULTI_MOD_TREE_THRESHOLD || groups.size() < 2 * MULTI_MOD_LEAF_GROUPS) {
+		limbs::multi_mod_1(group_rems.data(), a.data(), a.size(), groups.data(), groups.size());
+	}
+	else {
+		// the tree starts at products of MULTI_MOD_LEAF_GROUPS groups, built on
+		// chunk arrays; each leaf's remainder then takes one pass
+		size_t leaf_size = MULTI_MOD_LEAF_GROUPS;
+		std::vector<big_integer> leaves;
+		std::vector<uint> leaf(leaf_size + 1);
+		for (size_t from = 0; from < groups.size(); from += leaf_size) {
+			size_t size = 1;
+			leaf[0] = 1;
+			for (size_t g = from; g != std::min(groups.size(), from + leaf_size); ++g) {
+				leaf[size] = limbs::mul_1(leaf.data(), leaf.data(), size, groups[g]);
+				++size;
+			}
+			leaves.push_back(fixed_detail::to_big_integer(leaf.data(), size, false));
+		}
+
+		tree_levels levels = product_tree(std::move(leaves), a.size());
+		std::vector<big_integer> rems = remainders(negative ? -x : x, levels, 0);
+		for (size_t i = 0; i != rems.size(); ++i) {
+			size_t from = i * leaf_size, to = std::min(groups.size(), from + leaf_size);
+			std::vector<uint> r = magnitude(rems[i]);
+			limbs::multi_mod_1(group_rems.data() + from, r.data(), r.size(), groups.data() + from, to - from);
+		}
+	}
+
+	std::vector<uint> res(moduli.size());
+	for (size_t i = 0, g = 0; i != moduli.size(); ++i) {
+		if (i == group_end[g]) {
+			++g;
+		}
+		uint r = group_rems[g] % moduli[i];
+		res[i] = (negative && r != 0) ? moduli[i] - r : r;
+	}
+	return res;
+}
+
+std::vector<big_integer> multi_mod(big_integer const &x, std::vector<big_integer> const &moduli)
+{
+	if (moduli.empty()) {
+		return {};
+	}
+	for (big_integer const &m : moduli) {
+		if (m <= 0) {
+			throw std::runtime_error((m == 0) ? "division by 0" : "multi_mod: negative modulus");
+		}
+	}
+
+	std::vector<big_integer> res = remainders(x, product_tree(moduli, x.get_data_size()), 0);
+	for (size_t i = 0; i != res.size(); ++i) {
+		if (res[i] < 0) {
+			res[i] += moduli[i];
+		}
+	}
+	return res;
+}
@@ -0,0 +1,21 @@
+#ifndef BIG_INTEGER_MULTI_MOD_H
+#define BIG_INTEGER_MULTI_MOD_H
+
+#include "big_integer.h"
+
+#include <cstdint>
+#include <vector>
+
+// x mod m for every m of moduli, each in [0, m) also for negative x.
+// x goes down a remainder tree (x mod the product of all moduli, that mod the
+// product of each half, and so on) instead of one full division of x per
+// modulus; zero moduli throw.
+
+// word-sized moduli are packed into products that fit a chunk, and the tree
+// stops at nodes of a few chunks, which go through limbs::multi_mod_1
+std::vector<std::uint32_t> multi_mod(big_integer const &x, std::vector<std::uint32_t> const &moduli);
+
+// moduli > 0
+std::vector<big_integer> multi_mod(big_integer const &x, std::vector<big_integer> const &moduli);
+
+#endif // BIG_INTEGER_MULTI_MOD_H
@@ -1,6 +1,7 @@
 #define _SCL_SECURE_NO_WARNINGS
 
 #include "my_vector.h"
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <string.h>
@@ -11,18 +12,62 @@ using uint = std::uint32_t;
 
 constexpr size_t UINT_SIZE = sizeof(uint);
 
+namespace {
+	thread_local my_vector::hook_counters thread_counters = {0, 0, 0, 0};
+	std::atomic<my_vector::hook_type> current_hook(nullptr);
+	std::atomic<void *> current_context(nullptr);
+}
+
+my_vector::hook_counters my_vector::counters()
+{
+	return thread_counters;
+}
+
+void my_vector::reset_counters()
+{
+	thread_counters = {0, 0, 0, 0};
+}
+
+void my_vector::set_hook(hook_type hook, void *context)
+{
+	current_context.store(context);
+	current_hook.store(hook);
+}
+
+void my_vector::trace(event kind, size_t bytes, char const *site)
+{
+	if (kind == event::allocation) {
+		++thread_counters.allocations;
+		thread_counters.allocated_bytes += bytes;
+	}
+	else {
+		++thread_counters.detaches;
+		thread_counters.detached_bytes += bytes;
+	}
+	hook_type hook = current_hook.load(std::memory_order_acquire);
+	if (hook != nullptr) {
+		hook(kind, bytes, site, current_context.load(std::memory_order_relaxed));
+	}
+}
+
+shp_type my_vector::allocate(size_t n, char const *site)
+{
+	trace(event::allocation, n * UINT_SIZE, site);
+	return shp_type(new uint[n], std::default_delete<uint[]>());
+}
+
 my_vector::my_vector()
-	: vector_size(0), big_object(), is_small(true), cur_ptr(small_object)
+	: vector_size(0), big_object(), is_small(true), is_borrowed(false), cur_ptr(small_object)
 {
 	std::fill(cur_ptr, cur_ptr + SMALL_CAPACITY, 0);
 }
 
 my_vector::my_vector(size_t required_size)
-	: vector_size(required_size), big_object(), is_small(required_size <= SMALL_CAPACITY)
+	: vector_size(required_size), big_object(), is_small(required_size <= SMALL_CAPACITY), is_borrowed(false)
 {
 	if (!is_small) {
 		big_object.capacity = required_size;
-		new(&big_object.big_ptr) shp_type(new uint[required_size], std::default_delete<uint[]>());
+		new(&big_object.big_ptr) shp_type(allocate(required_size, "my_vector"));
 		cur_ptr = big_object.big_ptr.get();
 	}
 	else {
@@ -32,11 +77,11 @@ my_vector::my_vector(size_t required_size)
 }
 
 my_vector::my_vector(size_t required_size, uint value)
-	: vector_size(required_size), big_object(), is_small(required_size <= SMALL_CAPACITY)
+	: vector_size(required_size), big_object(), is_small(required_size <= SMALL_CAPACITY), is_borrowed(false)
 {
 	if (!is_small) {
 		big_object.capacity = required_size;
-		new(&big_object.big_ptr) shp_type(new uint[required_size], std::default_delete<uint[]>());
+		new(&big_object.big_ptr) shp_type(allocate(required_size, "my_vector"));
 		cur_ptr = big_object.big_ptr.get();
 	}
 	else {
@@ -47,7 +92,7 @@ my_vector::my_vector(size_t required_size, uint value)
 }
 
 my_vector::my_vector(my_vector const & other) noexcept
-	: vector_size(other.size()), is_small(other.is_small)
+	: vector_size(other.size()), is_small(other.is_small), is_borrowed(other.is_borrowed)
 {
 	if (!other.is_small) {
 		big_object.capacity = other.big_object.capacity;
@@ -67,6 +112,7 @@ my_vector & my_vector::operator=(my_vector const & other) noexcept
 
 	vector_size = other.vector_size;
 	is_small = other.is_small;
+	is_borrowed = other.is_borrowed;
 	if (!other.is_small) {
 		big_object.capacity = other.big_object.capacity;
 		new (&big_object.big_ptr) shp_type(other.big_object.big_ptr);
@@ -84,24 +130,29 @@ my_vector::~my_vector() {
 		big_object.~data_storage();
 }
 
-uint & my_vector::operator[](size_t index)
-{
-	assert(index < vector_size && "vector subscript out of range");
-
-	make_unique_copy();
-	return cur_ptr[index];
-}
-
-uint const & my_vector::operator[](size_t index) const
+my_vector my_vector::adopt(std::shared_ptr<void const> owner, uint const *data, size_t n)
 {
-	assert(index < vector_size && "vector subscript out of range");
+	if (n <= SMALL_CAPACITY) {
+		my_vector res(n);
+		std::copy(data, data + n, res.cur_ptr);
+		return res;
+	}
 
-	return cur_ptr[index];
+	my_vector res;
+	res.vector_size = n;
+	res.is_small = false;
+	res.is_borrowed = true;
+	new (&res.big_object) data_storage();
+	// aliases owner's control block, so owner lives as long as any copy
+	res.big_object.big_ptr = shp_type(std::const_pointer_cast<void>(owner), const_cast<uint *>(data));
+	res.big_object.capacity = n;
+	res.cur_ptr = res.big_object.big_ptr.get();
+	return res;
 }
 
 void my_vector::push_back(uint const value)
 {
-	assert(is_small || big_object.big_ptr.unique());
+	assert(is_small || (!is_borrowed && big_object.big_ptr.unique()));
 
 	ensure_capacity(estimate_capacity(vector_size + 1));
 
@@ -112,7 +163,7 @@ void my_vector::push_back(uint const value)
 void my_vector::pop_back()
 {
 	assert(vector_size != 0);
-	assert(is_small || big_object.big_ptr.unique());
+	assert(is_small || (!is_borrowed && big_object.big_ptr.unique()));
 
 	ensure_capacity(estimate_capacity(vector_size - 1));
 	--vector_size;
@@ -125,11 +176,6 @@ uint & my_vector::back() const
 	return cur_ptr[vector_size - 1];
 }
 
-size_t my_vector::size() const
-{
-	return vector_size;
-}
-
 size_t my_vector::capacity() const
 {
 	if (is_small)
@@ -147,6 +193,13 @@ void my_vector::clear()
 {
 	vector_size = 0;
 	big_object.big_ptr = nullptr;
+	is_borrowed = false;
+}
+
+void my_vector::reserve(size_t n)
+{
+	make_unique_copy();
+	ensure_capacity(n);
 }
 
 void my_vector::resize(size_t n)
@@ -157,6 +210,7 @@ void my_vector::resize(size_t n)
 void my_vector::resize(size_t n, uint value)
 {
 	size_t old_size = vector_size;
+	make_unique_copy();
 	ensure_capacity(n);
 
 	if (n > old_size) {
@@ -205,20 +259,19 @@ void my_vector::swap(my_vector & other) noexcept
 		}
 	}
 	swap(vector_size, other.vector_size);
+	swap(is_borrowed, other.is_borrowed);
 }
 
-void my_vector::make_unique_copy()
+void my_vector::detach()
 {
-	if (!is_small && !big_object.big_ptr.unique()) {
-		my_vector tmp(big_object.capacity);
-		std::copy(
-			big_object.big_ptr.get(),
-			big_object.big_ptr.get() + big_object.capacity,
-			tmp.big_object.big_ptr.get()
-		);
-		*this = tmp;
-		cur_ptr = big_object.big_ptr.get();
-	}
+	size_t bytes = big_object.capacity * UINT_SIZE;
+	trace(event::detach, bytes, "make_unique_copy");
+
+	shp_type storage = allocate(big_object.capacity, "make_unique_copy");
+	std::copy(cur_ptr, cur_ptr + big_object.capacity, storage.get());
+	big_object.big_ptr = storage;
+	cur_ptr = storage.get();
+	is_borrowed = false;
 }
 
 void my_vector::reverse()
@@ -245,20 +298,21 @@ size_t my_vector::estimate_capacity(size_t new_size)
 inline void my_vector::ensure_capacity(size_t new_capacity)
 {
 	size_t old_capacity = capacity();
-	size_t old_size = size();
 
 	if (new_capacity <= old_capacity)
 		return;
 
-	my_vector tmp(new_capacity);
-	std::copy(cur_ptr, cur_ptr + old_capacity, tmp.big_object.big_ptr.get());
-	if (old_capacity == SMALL_CAPACITY) {
+	shp_type storage = allocate(new_capacity, "ensure_capacity");
+	std::copy(cur_ptr, cur_ptr + old_capacity, storage.get());
+	std::fill(storage.get() + old_capacity, storage.get() + new_capacity, 0);
+	if (is_small) {
 		is_small = false;
-		std::fill(small_object, small_object + SMALL_CAPACITY, 0);
+		new (&big_object) data_storage();
 	}
-	*this = tmp;
-	vector_size = old_size;
-	cur_ptr = tmp.big_object.big_ptr.get();
+	big_object.big_ptr = storage;
+	big_object.capacity = new_capacity;
+	cur_ptr = storage.get();
+	is_borrowed = false;
 }
 
 void my_vector::remove_last_zeros()
@@ -273,27 +327,7 @@ void my_vector::remove_last_zeros()
 	}
 }
 
-uint* my_vector::begin() noexcept
-{
-	return cur_ptr;
-}
-
-uint const* my_vector::begin() const noexcept
-{
-	return cur_ptr;
-}
-
-uint* my_vector::end() noexcept
-{
-	return cur_ptr + vector_size;
-}
-
-uint const* my_vector::end() const noexcept
-{
-	return cur_ptr + vector_size;
-}
-
-std::reverse_iterator<uint*> my_vector::rbegin() noexcept
+std::reverse_iterator<uint*> my_vector::rbegin()
 {
 	return make_reverse_iterator(end());
 }
@@ -303,7 +337,7 @@ std::reverse_iterator<const uint*> my_vector::rbegin() const noexcept
 	return make_reverse_iterator(end());
 }
 
-std::reverse_iterator<uint*> my_vector::rend() noexcept
+std::reverse_iterator<uint*> my_vector::rend()
 {
 	return make_reverse_iterator(begin());
 }
@@ -7,6 +7,8 @@
 #include <string.h>
 #include <iterator>
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 
 using std::shared_ptr;
 
@@ -16,6 +18,28 @@ class my_vector {
 public:
 	using uint = std::uint32_t;
 	using ll = std::int64_t;
+	using ull = std::uint64_t;
+
+	// heap traffic tracing: every allocation and every copy-on-write detach is
+	// counted per thread and passed to the hook, if one is set
+	enum class event { allocation, detach };
+
+	// bytes allocated or copied; site is the my_vector function that caused it
+	using hook_type = void (*)(event kind, size_t bytes, char const *site, void *context);
+
+	struct hook_counters {
+		ull allocations;
+		ull allocated_bytes;
+		ull detaches;
+		ull detached_bytes;
+	};
+
+	// counters of the calling thread
+	static hook_counters counters();
+	static void reset_counters();
+
+	// hook is shared by all threads and may be called concurrently; nullptr removes it
+	static void set_hook(hook_type hook, void *context = nullptr);
 
 private:
 	static constexpr size_t SMALL_CAPACITY = 4;
@@ -39,11 +63,18 @@ private:
 	};
 
 	bool is_small;
+	// the big buffer belongs to someone else (see adopt) and is never written,
+	// as if it were shared
+	bool is_borrowed;
 	uint * cur_ptr;
 
 	size_t estimate_capacity(size_t new_size);
 	inline void ensure_capacity(size_t new_capacity);
 
+	static shp_type allocate(size_t n, char const *site);
+	static void trace(event kind, size_t bytes, char const *site);
+	void detach();
+
 public:
 
 	my_vector();
@@ -53,6 +84,10 @@ public:
 	my_vector& operator=(my_vector const & other) noexcept;
 	~my_vector();
 
+	// n elements at data without copying them: owner keeps them alive, and the
+	// first write copies them as for a shared buffer (small sizes are copied at once)
+	static my_vector adopt(std::shared_ptr<void const> owner, uint const *data, size_t n);
+
 	uint& operator[](size_t index);
 	uint const & operator[](size_t index) const;
 
@@ -66,6 +101,8 @@ public:
 	bool empty() const;
 	void clear();
 
+	// capacity for at least n elements
+	void reserve(size_t n);
 	void resize(size_t n);
 	void resize(size_t n, uint value);
 
@@ -77,9 +114,9 @@ public:
 
 	void remove_last_zeros();
 
-	uint* begin() noexcept;
+	uint* begin();
 	uint const* begin() const noexcept;
-	uint* end() noexcept;
+	uint* end();
 	uint const* end() const noexcept;
 
 	template<typename Iterator>
@@ -92,10 +129,61 @@ public:
 		return std::reverse_iterator<Iterator>(i);
 	}
 
-	std::reverse_iterator< uint* > rbegin() noexcept;
+	std::reverse_iterator< uint* > rbegin();
 	std::reverse_iterator< const uint* > rbegin() const noexcept;
-	std::reverse_iterator< uint* > rend() noexcept;
+	std::reverse_iterator< uint* > rend();
 	std::reverse_iterator< const uint* > rend() const noexcept;
 };
 
+// element access is on every hot loop, keep it inlinable
+
+inline void my_vector::make_unique_copy()
+{
+	if (!is_small && (is_borrowed || !big_object.big_ptr.unique())) {
+		detach();
+	}
+}
+
+inline my_vector::uint & my_vector::operator[](size_t index)
+{
+	assert(index < vector_size && "vector subscript out of range");
+
+	make_unique_copy();
+	return cur_ptr[index];
+}
+
+inline my_vector::uint const & my_vector::operator[](size_t index) const
+{
+	assert(index < vector_size && "vector subscript out of range");
+
+	return cur_ptr[index];
+}
+
+inline size_t my_vector::size() const
+{
+	return vector_size;
+}
+
+inline my_vector::uint* my_vector::begin()
+{
+	make_unique_copy();
+	return cur_ptr;
+}
+
+inline my_vector::uint const* my_vector::begin() const noexcept
+{
+	return cur_ptr;
+}
+
+inline my_vector::uint* my_vector::end()
+{
+	make_unique_copy();
+	return cur_ptr + vector_size;
+}
+
+inline my_vector::uint const* my_vector::end() const noexcept
+{
+	return cur_ptr + vector_size;
+}
+
 #endif //OPTS_MY_VECTOR_H
\ No newline at end of file
@@ -0,0 +1,193 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+	namespace {
+		using task = std::function<void()>;
+
+		// queues[0] is shared by the threads outside the pool, queues[i] belongs to worker i
+		class pool {
+		public:
+			explicit pool(size_t workers)
+				: queued(0), stop(false) {
+				for (size_t i = 0; i <= workers; ++i) {
+					queues.emplace_back(new queue);
+				}
+				for (size_t i = 1; i <= workers; ++i) {
+					threads.emplace_back([this, i] { work(i); });
+				}
+			}
+
+			~pool() {
+				{
+					std::lock_guard<std::mutex> guard(sleep_lock);
+					stop = true;
+				}
+				wake.notify_all();
+				for (std::thread &t : threads) {
+					t.join();
+				}
+			}
+
+			void push(task t) {
+				queue &own = *queues[current];
+				{
+					std::lock_guard<std::mutex> guard(own.lock);
+					own.tasks.push_back(std::move(t));
+				}
+				queued.fetch_add(1);
+				{
+					// taken so that a worker between its check and its wait sees the task
+					std::lock_guard<std::mutex> guard(sleep_lock);
+				}
+				wake.notify_one();
+			}
+
+			// runs one queued task, the most recent of the caller's own or the oldest of another queue
+			bool run_one() {
+				task t;
+				if (!take(t)) {
+					return false;
+				}
+				t();
+				return true;
+			}
+
+		private:
+			struct queue {
+				std::mutex lock;
+				std::deque<task> tasks;
+			};
+
+			static thread_local size_t current;
+
+			std::vector<std::unique_ptr<queue>> queues;
+			std::vector<std::thread> threads;
+			std::atomic<size_t> queued;
+
+			std::mutex sleep_lock;
+			std::condition_variable wake;
+			bool stop;
+
+			bool take(task &t) {
+				if (queued.load() == 0) {
+					return false;
+				}
+				for (size_t k = 0; k != queues.size(); ++k) {
+					queue &q = *queues[(current + k) % queues.size()];
+					std::lock_guard<std::mutex> guard(q.lock);
+					if (q.tasks.empty()) {
+						continue;
+					}
+					if (k == 0) {
+						t = std::move(q.tasks.back());
+						q.tasks.pop_back();
+					}
+					else {
+						t = std::move(q.tasks.front());
+						q.tasks.pop_front();
+					}
+					queued.fetch_sub(1);
+					return true;
+				}
+				return false;
+			}
+
+			void work(size_t index) {
+				current = index;
+				for (;;) {
+					if (run_one()) {
+						continue;
+					}
+					std::unique_lock<std::mutex> guard(sleep_lock);
+					wake.wait(guard, [this] { return stop || queued.load() != 0; });
+					if (stop) {
+						return;
+					}
+				}
+			}
+		};
+
+		thread_local size_t pool::current = 0;
+
+		pool &instance()
+		{
+			static pool p(hardware_threads() - 1);
+			return p;
+		}
+	}
+
+	size_t hardware_threads()
+	{
+		// hardware_concurrency reads the system configuration on every call
+		static size_t const threads = std::max(std::thread::hardware_concurrency(), 1u);
+		return threads;
+	}
+
+	policy::policy(size_t threads)
+		: threads(threads == 0 ? 1 : threads) {
+	}
+
+	task_group::task_group()
+		: pending(0) {
+	}
+
+	task_group::~task_group()
+	{
+		wait_all();
+	}
+
+	void task_group::run(std::function<void()> t)
+	{
+		pending.fetch_add(1);
+		instance().push([this, t = std::move(t)] {
+			try {
+				t();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> guard(error_lock);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+			// under the lock, so that the group outlives the notification
+			std::lock_guard<std::mutex> guard(done_lock);
+			pending.fetch_sub(1, std::memory_order_release);
+			done.notify_all();
+		});
+	}
+
+	void task_group::wait()
+	{
+		wait_all();
+		if (error) {
+			std::exception_ptr e = error;
+			error = nullptr;
+			std::rethrow_exception(e);
+		}
+	}
+
+	void task_group::wait_all()
+	{
+		while (pending.load(std::memory_order_acquire) != 0) {
+			if (instance().run_one()) {
+				continue;
+			}
+			// the remaining tasks are running on other threads; sleep until one
+			// finishes, then look for queued ones again
+			std::unique_lock<std::mutex> guard(done_lock);
+			size_t seen = pending.load(std::memory_order_acquire);
+			done.wait(guard, [this, seen] { return seen == 0 || pending.load(std::memory_order_acquire) != seen; });
+		}
+		// the last task may still hold done_lock, which must outlive it
+		std::lock_guard<std::mutex> guard(done_lock);
+	}
+}
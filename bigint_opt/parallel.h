@@ -0,0 +1,55 @@
+#ifndef OPTS_PARALLEL_H
+#define OPTS_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Opt-in multithreading for the largest operations.
+//
+// A policy caps the number of threads one call may use. The call splits its
+// work into tasks for a process-wide work-stealing pool with one worker per
+// hardware thread beyond the first: each thread pushes and pops its own queue
+// at the back and idle ones steal from the front of the others. A thread
+// waiting for its tasks runs queued ones meanwhile, so nested splitting cannot
+// deadlock, and sleeps once there are none left to take.
+namespace parallel {
+	size_t hardware_threads();
+
+	// threads a call may use, the calling one included; 1 runs sequentially
+	struct policy {
+		size_t threads;
+
+		explicit policy(size_t threads = hardware_threads());
+	};
+
+	// tasks that may run on the pool; all must finish before the group is destroyed
+	class task_group {
+	public:
+		task_group();
+		// waits for the remaining tasks, dropping their exceptions
+		~task_group();
+
+		task_group(task_group const &) = delete;
+		task_group &operator=(task_group const &) = delete;
+
+		void run(std::function<void()> task);
+		// returns when every task has finished, rethrows the first exception one threw
+		void wait();
+
+	private:
+		std::atomic<size_t> pending;
+		std::mutex error_lock;
+		std::exception_ptr error;
+		// a finished task lowers pending under done_lock and notifies done
+		std::mutex done_lock;
+		std::condition_variable done;
+
+		void wait_all();
+	};
+}
+
+#endif // OPTS_PARALLEL_H
@@ -0,0 +1,461 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "primes.h"
+#include "ifma.h"
+#include "limbs.h"
+#include "multi_mod.h"
+#include "roots.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+using ll = std::int64_t;
+
+extern const uint CHUNK_BIT_SIZE;
+
+constexpr uint SMALL_PRIME_LIMIT = 4096;
+constexpr size_t SIEVE_WINDOW = 4096;
+
+std::vector<uint> primes_up_to(uint n)
+{
+	std::vector<uint> primes;
+	if (n < 2) {
+		return primes;
+	}
+	std::vector<bool> composite(n + 1, false);
+	for (ull i = 2; i <= n; ++i) {
+		if (composite[i]) {
+			continue;
+		}
+		primes.push_back((uint)i);
+		for (ull j = i * i; j <= n; j += i) {
+			composite[j] = true;
+		}
+	}
+	return primes;
+}
+
+namespace {
+	// odd primes below SMALL_PRIME_LIMIT
+	struct small_prime_table {
+		std::vector<uint> primes;
+
+		small_prime_table()
+		{
+			std::vector<uint> all = primes_up_to(SMALL_PRIME_LIMIT - 1);
+			primes.assign(all.begin() + 1, all.end());
+		}
+
+		// n mod p for every prime of the table
+		std::vector<uint> residues(big_integer const &n) const
+		{
+			return multi_mod(n, primes);
+		}
+	};
+
+	// arithmetic modulo an odd n of at least two chunks, values kept in Montgomery form;
+	// products go through ifma::montgomery when it is active, with its own radix
+	class montgomery_ring {
+	public:
+		using residue = std::vector<uint>;
+
+		explicit montgomery_ring(big_integer const &modulus)
+			: n(modulus),
+			size(modulus.get_data_size()),
+			mod(chunks_of(modulus, size)),
+			m_inv(0 - limbs::inverse_mod_base(mod[0])),
+			scratch(size + 2)
+		{
+			if (size >= IFMA_MONT_THRESHOLD && size < ifma::MONT_LIMIT && ifma::active()) {
+				fast.reset(new ifma::montgomery(mod.data(), size));
+			}
+			radix_bits = fast ? fast->radix_bits() : size * CHUNK_BIT_SIZE;
+		}
+
+		residue from(big_integer const &x) const
+		{
+			return chunks_of((x << (int)radix_bits) % n, size);
+		}
+
+		residue zero() const
+		{
+			return residue(size, 0);
+		}
+
+		residue mul(residue const &a, residue const &b)
+		{
+			residue res(size);
+			if (fast) {
+				fast->mul(res.data(), a.data(), b.data());
+			}
+			else {
+				limbs::mont_mul(res.data(), a.data(), b.data(), mod.data(), size, m_inv, scratch.data());
+			}
+			return res;
+		}
+
+		residue add(residue const &a, residue const &b) const
+		{
+			residue res(size);
+			uint carry = limbs::add_n(res.data(), a.data(), b.data(), size);
+			if (carry != 0 || limbs::cmp(res.data(), mod.data(), size) >= 0) {
+				limbs::sub_n(res.data(), res.data(), mod.data(), size);
+			}
+			return res;
+		}
+
+		residue sub(residue const &a, residue const &b) const
+		{
+			residue res(size);
+			if (limbs::sub_n(res.data(), a.data(), b.data(), size) != 0) {
+				limbs::add_n(res.data(), res.data(), mod.data(), size);
+			}
+			return res;
+		}
+
+		residue half(residue const &a) const
+		{
+			residue res(a);
+			uint carry = 0;
+			if (res[0] & 1) {
+				carry = limbs::add_n(res.data(), res.data(), mod.data(), size);
+			}
+			limbs::rshift(res.data(), res.data(), size, 1);
+			res[size - 1] |= carry << (CHUNK_BIT_SIZE - 1);
+			return res;
+		}
+
+		residue mul_small(residue const &a, uint c) const
+		{
+			residue prod(size + 1), quotient(2), res(size);
+			prod[size] = limbs::mul_1(prod.data(), a.data(), size, c);
+			limbs::divrem(quotient.data(), res.data(), prod.data(), size + 1, mod.data(), size);
+			return res;
+		}
+
+		// base^exp for exp > 0, four exponent bits at a time
+		residue pow(residue const &base, big_integer const &exp)
+		{
+			std::vector<residue> table(16, from(1));
+			for (size_t i = 1; i != table.size(); ++i) {
+				table[i] = mul(table[i - 1], base);
+			}
+
+			residue res = table[0];
+			for (size_t i = exp.get_data_size(); i--;) {
+				uint chunk = exp.get_chunk(i);
+				for (int shift = (int)CHUNK_BIT_SIZE - 4; shift >= 0; shift -= 4) {
+					for (int j = 0; j != 4; ++j) {
+						res = mul(res, res);
+					}
+					uint digit = (chunk >> shift) & 15;
+					if (digit != 0) {
+						res = mul(res, table[digit]);
+					}
+				}
+			}
+			return res;
+		}
+
+	private:
+		big_integer n;
+		size_t size;
+		residue mod;
+		uint m_inv;
+		residue scratch;
+		std::unique_ptr<ifma::montgomery> fast;
+		// log2 of the Montgomery radix
+		size_t radix_bits;
+
+		static residue chunks_of(big_integer const &x, size_t size)
+		{
+			residue res(size, 0);
+			for (size_t i = 0; i != std::min(size, x.get_data_size()); ++i) {
+				res[i] = x.get_chunk(i);
+			}
+			return res;
+		}
+	};
+}
+
+static small_prime_table const &small_primes()
+{
+	static small_prime_table const table;
+	return table;
+}
+
+static ull pow_mod_64(ull base, ull exp, ull mod)
+{
+	ull res = 1;
+	base %= mod;
+	while (exp != 0) {
+		if (exp & 1) {
+			res = res * base % mod;
+		}
+		base = base * base % mod;
+		exp >>= 1;
+	}
+	return res;
+}
+
+// deterministic for every n < 2^32
+static bool is_prime_single_chunk(uint n)
+{
+	if (n < 2) {
+		return false;
+	}
+	else if (n % 2 == 0) {
+		return n == 2;
+	}
+	for (uint p : small_primes().primes) {
+		if ((ull)p * p > n) {
+			return true;
+		}
+		else if (n % p == 0) {
+			return false;
+		}
+	}
+
+	uint d = n - 1, s = 0;
+	while (d % 2 == 0) {
+		d /= 2;
+		++s;
+	}
+	for (uint base : { 2u, 7u, 61u }) {
+		ull y = pow_mod_64(base, d, n);
+		if (y == 1 || y == n - 1) {
+			continue;
+		}
+		uint r = 1;
+		for (; r < s && y != n - 1; ++r) {
+			y = y * y % n;
+		}
+		if (y != n - 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int jacobi_small(ull a, ull m)
+{
+	int res = 1;
+	a %= m;
+	while (a != 0) {
+		while (a % 2 == 0) {
+			a /= 2;
+			if (m % 8 == 3 || m % 8 == 5) {
+				res = -res;
+			}
+		}
+		std::swap(a, m);
+		if (a % 4 == 3 && m % 4 == 3) {
+			res = -res;
+		}
+		a %= m;
+	}
+	return (m == 1) ? res : 0;
+}
+
+// Jacobi symbol (a / n) for odd n > |a|
+static int jacobi(ll a, big_integer const &n)
+{
+	int res = 1;
+	uint n_low = n.get_chunk(0);
+	if (a < 0) {
+		a = -a;
+		if (n_low % 4 == 3) {
+			res = -res;
+		}
+	}
+
+	ull x = (ull)a;
+	while (x % 2 == 0) {
+		x /= 2;
+		if (n_low % 8 == 3 || n_low % 8 == 5) {
+			res = -res;
+		}
+	}
+	if (x == 1) {
+		return res;
+	}
+
+	// reciprocity turns (x / n) into (n mod x / x)
+	if (x % 4 == 3 && n_low % 4 == 3) {
+		res = -res;
+	}
+	ull n_mod_x = (n % big_integer((uint)x)).get_chunk(0);
+	return res * jacobi_small(n_mod_x, x);
+}
+
+static bool strong_miller_rabin(montgomery_ring &ring, big_integer const &n, uint base)
+{
+	big_integer n_minus_1 = n - 1;
+	size_t s = n_minus_1.ctz();
+	big_integer d = n_minus_1 >> (int)s;
+
+	montgomery_ring::residue one = ring.from(1), minus_one = ring.from(n_minus_1);
+	montgomery_ring::residue y = ring.pow(ring.from(big_integer(base)), d);
+	if (y == one || y == minus_one) {
+		return true;
+	}
+	for (size_t r = 1; r < s; ++r) {
+		y = ring.mul(y, y);
+		if (y == minus_one) {
+			return true;
+		}
+		else if (y == one) {
+			return false;
+		}
+	}
+	return false;
+}
+
+// strong Lucas probable prime test with Selfridge's parameters P = 1, Q = (1 - D) / 4
+static bool strong_lucas(montgomery_ring &ring, big_integer const &n)
+{
+	ll D = 5;
+	for (int attempt = 0; ; ++attempt) {
+		int j = jacobi(D, n);
+		if (j == -1) {
+			break;
+		}
+		else if (j == 0) {
+			return false;
+		}
+		else if (attempt == 10 && isqrt(n) * isqrt(n) == n) {
+			return false;
+		}
+		D = (D > 0) ? -(D + 2) : -(D - 2);
+	}
+
+	ll Q = (1 - D) / 4;
+	montgomery_ring::residue q_form = (Q >= 0)
+		? ring.from(big_integer((ull)Q))
+		: ring.from(n - big_integer((ull)-Q));
+
+	big_integer n_plus_1 = n + 1;
+	size_t s = n_plus_1.ctz();
+	big_integer d = n_plus_1 >> (int)s;
+
+	montgomery_ring::residue u = ring.from(1), v = u, q_k = q_form;
+	montgomery_ring::residue zero = ring.zero();
+	for (size_t i = d.bit_length() - 1; i--;) {
+		u = ring.mul(u, v);
+		v = ring.sub(ring.mul(v, v), ring.add(q_k, q_k));
+		q_k = ring.mul(q_k, q_k);
+		if (d.test_bit(i)) {
+			montgomery_ring::residue d_u = ring.mul_small(u, (uint)(D > 0 ? D : -D));
+			if (D < 0) {
+				d_u = ring.sub(zero, d_u);
+			}
+			montgomery_ring::residue next_u = ring.half(ring.add(u, v));
+			v = ring.half(ring.add(d_u, v));
+			u = next_u;
+			q_k = ring.mul(q_k, q_form);
+		}
+	}
+
+	if (u == zero || v == zero) {
+		return true;
+	}
+	for (size_t r = 1; r < s; ++r) {
+		v = ring.sub(ring.mul(v, v), ring.add(q_k, q_k));
+		q_k = ring.mul(q_k, q_k);
+		if (v == zero) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// n is odd, has at least two chunks and no small prime factors
+static bool probable_prime_test(big_integer const &n, unsigned extra_rounds)
+{
+	montgomery_ring ring(n);
+	if (!strong_miller_rabin(ring, n, 2) || !strong_lucas(ring, n)) {
+		return false;
+	}
+
+	std::vector<uint> const &bases = small_primes().primes;
+	for (unsigned i = 0; i != extra_rounds && i != bases.size(); ++i) {
+		if (!strong_miller_rabin(ring, n, bases[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool is_probable_prime(big_integer const &n, unsigned extra_rounds)
+{
+	if (n.signum <= 0) {
+		return false;
+	}
+	else if (n.get_data_size() == 1) {
+		return is_prime_single_chunk(n.get_chunk(0));
+	}
+	else if (n.get_chunk(0) % 2 == 0) {
+		return false;
+	}
+
+	std::vector<uint> residues = small_primes().residues(n);
+	if (std::find(residues.begin(), residues.end(), 0) != residues.end()) {
+		return false;
+	}
+	return probable_prime_test(n, extra_rounds);
+}
+
+big_integer next_prime(big_integer const &n)
+{
+	if (n < 2) {
+		return 2;
+	}
+
+	big_integer start = n + 1;
+	if (start.get_chunk(0) % 2 == 0) {
+		++start;
+	}
+	if (start.get_data_size() == 1) {
+		for (ull candidate = start.get_chunk(0); candidate <= UINT32_MAX; candidate += 2) {
+			if (is_prime_single_chunk((uint)candidate)) {
+				return big_integer(candidate);
+			}
+		}
+		start = big_integer((ull)UINT32_MAX + 2);
+	}
+
+	// sieve windows of odd candidates start + 2k by the small primes,
+	// carrying the residues of start from one window to the next
+	small_prime_table const &table = small_primes();
+	std::vector<uint> residues = table.residues(start);
+	std::vector<bool> composite(SIEVE_WINDOW);
+	while (true) {
+		std::fill(composite.begin(), composite.end(), false);
+		for (size_t i = 0; i != table.primes.size(); ++i) {
+			ull p = table.primes[i];
+			// start + 2k = 0 (mod p)  <=>  k = -residue / 2 (mod p)
+			ull k = (p - residues[i]) % p * ((p + 1) / 2) % p;
+			for (; k < SIEVE_WINDOW; k += p) {
+				composite[k] = true;
+			}
+		}
+
+		for (size_t k = 0; k != SIEVE_WINDOW; ++k) {
+			if (composite[k]) {
+				continue;
+			}
+			big_integer candidate = start + big_integer((ull)(2 * k));
+			if (probable_prime_test(candidate, 0)) {
+				return candidate;
+			}
+		}
+
+		start += big_integer((ull)(2 * SIEVE_WINDOW));
+		for (size_t i = 0; i != table.primes.size(); ++i) {
+			residues[i] = (uint)((residues[i] + 2 * SIEVE_WINDOW) % table.primes[i]);
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef BIG_INTEGER_PRIMES_H
+#define BIG_INTEGER_PRIMES_H
+
+#include "big_integer.h"
+
+#include <cstdint>
+#include <vector>
+
+// all primes p <= n
+std::vector<std::uint32_t> primes_up_to(std::uint32_t n);
+
+// trial division by the small-prime table, then BPSW (Miller-Rabin to base 2
+// and a strong Lucas test) and extra_rounds Miller-Rabin tests to further prime bases
+bool is_probable_prime(big_integer const &n, unsigned extra_rounds = 0);
+
+// smallest probable prime greater than n
+big_integer next_prime(big_integer const &n);
+
+#endif // BIG_INTEGER_PRIMES_H
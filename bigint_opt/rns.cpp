@@ -0,0 +1,276 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "rns.h"
+#include "cpu.h"
+#include "limbs.h"
+#include "primes.h"
+
+#include <atomic>
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+
+namespace {
+	// primes are taken from here down; all are above 2^30
+	constexpr uint LARGEST_MODULUS = 0x7FFFFFFF;
+	constexpr size_t MODULUS_BITS = 30;
+	// residues per AVX2 vector, the number of primes is a multiple of it
+	constexpr size_t LANES = 8;
+
+	std::atomic<bool> simd_enabled(true);
+
+	bool is_prime(uint n, std::vector<uint> const &divisors)
+	{
+		for (uint d : divisors) {
+			if ((ull)d * d > n) {
+				break;
+			}
+			if (n % d == 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// a * b / 2^32 mod p, a, b < p < 2^31, inv = -p^-1 mod 2^32
+	uint mont_mul(uint a, uint b, uint p, uint inv)
+	{
+		ull t = (ull)a * b;
+		uint m = (uint)t * inv;
+		uint u = (uint)((t + (ull)m * p) >> 32);
+		return (u >= p) ? u - p : u;
+	}
+
+	uint pow_mod(uint a, uint e, uint p)
+	{
+		ull res = 1, base = a % p;
+		for (; e != 0; e >>= 1) {
+			if (e & 1) {
+				res = res * base % p;
+			}
+			base = base * base % p;
+		}
+		return (uint)res;
+	}
+
+	// the lane kernels: count numbers of size residues, size a multiple of LANES
+
+	void add_scalar(uint *r, uint const *a, uint const *b, size_t count, uint const *p, size_t size)
+	{
+		for (size_t k = 0; k != count * size; ++k) {
+			uint s = a[k] + b[k], m = p[k % size];
+			r[k] = (s >= m) ? s - m : s;
+		}
+	}
+
+	void sub_scalar(uint *r, uint const *a, uint const *b, size_t count, uint const *p, size_t size)
+	{
+		for (size_t k = 0; k != count * size; ++k) {
+			r[k] = (a[k] >= b[k]) ? a[k] - b[k] : a[k] - b[k] + p[k % size];
+		}
+	}
+
+	void mul_scalar(uint *r, uint const *a, uint const *b, size_t count, uint const *p, uint const *inv, size_t size)
+	{
+		for (size_t k = 0; k != count * size; ++k) {
+			r[k] = mont_mul(a[k], b[k], p[k % size], inv[k % size]);
+		}
+	}
+
+#ifdef HAVE_X86_SIMD
+	// results in [0, 2p) are brought below p by an unsigned minimum with x - p,
+	// which wraps around for x < p
+
+	SIMD_TARGET("avx2")
+	void add_avx2(uint *r, uint const *a, uint const *b, size_t count, uint const *p, size_t size)
+	{
+		for (size_t j = 0; j != count * size; j += size) {
+			for (size_t i = 0; i != size; i += LANES) {
+				__m256i m = _mm256_loadu_si256((__m256i const *)(p + i));
+				__m256i s = _mm256_add_epi32(_mm256_loadu_si256((__m256i const *)(a + j + i)), _mm256_loadu_si256((__m256i const *)(b + j + i)));
+				_mm256_storeu_si256((__m256i *)(r + j + i), _mm256_min_epu32(s, _mm256_sub_epi32(s, m)));
+			}
+		}
+	}
+
+	SIMD_TARGET("avx2")
+	void sub_avx2(uint *r, uint const *a, uint const *b, size_t count, uint const *p, size_t size)
+	{
+		for (size_t j = 0; j != count * size; j += size) {
+			for (size_t i = 0; i != size; i += LANES) {
+				__m256i m = _mm256_loadu_si256((__m256i const *)(p + i));
+				__m256i d = _mm256_sub_epi32(_mm256_loadu_si256((__m256i const *)(a + j + i)), _mm256_loadu_si256((__m256i const *)(b + j + i)));
+				_mm256_storeu_si256((__m256i *)(r + j + i), _mm256_min_epu32(d, _mm256_add_epi32(d, m)));
+			}
+		}
+	}
+
+	// mont_mul on the even and the odd lanes, 32 x 32 -> 64 bit multiplies
+	SIMD_TARGET("avx2")
+	void mul_avx2(uint *r, uint const *a, uint const *b, size_t count, uint const *p, uint const *inv, size_t size)
+	{
+		for (size_t j = 0; j != count * size; j += size) {
+			for (size_t i = 0; i != size; i += LANES) {
+				__m256i m = _mm256_loadu_si256((__m256i const *)(p + i));
+				__m256i v = _mm256_loadu_si256((__m256i const *)(inv + i));
+				__m256i x = _mm256_loadu_si256((__m256i const *)(a + j + i));
+				__m256i y = _mm256_loadu_si256((__m256i const *)(b + j + i));
+				__m256i t_even = _mm256_mul_epu32(x, y);
+				__m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+				__m256i q_even = _mm256_mul_epu32(t_even, v);
+				__m256i q_odd = _mm256_mul_epu32(t_odd, _mm256_srli_epi64(v, 32));
+				__m256i u_even = _mm256_add_epi64(t_even, _mm256_mul_epu32(q_even, m));
+				__m256i u_odd = _mm256_add_epi64(t_odd, _mm256_mul_epu32(q_odd, _mm256_srli_epi64(m, 32)));
+				__m256i u = _mm256_blend_epi32(_mm256_srli_epi64(u_even, 32), u_odd, 0xAA);
+				_mm256_storeu_si256((__m256i *)(r + j + i), _mm256_min_epu32(u, _mm256_sub_epi32(u, m)));
+			}
+		}
+	}
+#endif
+}
+
+rns_context::rns_context(size_t bits)
+{
+	// trial division by the primes up to sqrt(2^31)
+	std::vector<uint> divisors = primes_up_to(46341);
+	for (uint n = LARGEST_MODULUS; moduli.size() * MODULUS_BITS < bits || moduli.size() % LANES != 0 || moduli.empty(); n -= 2) {
+		if (is_prime(n, divisors)) {
+			moduli.push_back(n);
+		}
+	}
+
+	for (uint p : moduli) {
+		inverses.push_back(0 - limbs::inverse_mod_base(p));
+		ull r = (1ull << 32) % p;
+		scales.push_back((uint)(r * r % p));
+	}
+
+	tree.emplace_back(moduli.begin(), moduli.end());
+	while (tree.back().size() != 1) {
+		std::vector<big_integer> const &below = tree.back();
+		std::vector<big_integer> level;
+		for (size_t i = 0; i < below.size(); i += 2) {
+			level.push_back((i + 1 < below.size()) ? below[i] * below[i + 1] : below[i]);
+		}
+		tree.push_back(std::move(level));
+	}
+
+	// (P / node) mod node from the root down: for children l and r of v,
+	// P / l = (P / v) r, so it is ((P / v) mod v) r mod l
+	std::vector<big_integer> rests(1, big_integer(1));
+	for (size_t l = tree.size() - 1; l-- != 0;) {
+		std::vector<big_integer> const &level = tree[l];
+		std::vector<big_integer> next(level.size());
+		for (size_t i = 0; i != level.size(); ++i) {
+			next[i] = (i % 2 == 0) ? rests[i / 2] : rests[i / 2] * level[i - 1];
+			if (i % 2 == 0 && i + 1 < level.size()) {
+				next[i] *= level[i + 1];
+			}
+			next[i] %= level[i];
+		}
+		rests = std::move(next);
+	}
+	for (size_t i = 0; i != moduli.size(); ++i) {
+		uint rest = rests[i].get_chunk(0);
+		weights.push_back(pow_mod(rest, moduli[i] - 2, moduli[i]));
+	}
+}
+
+void rns_context::to_rns(uint *r, big_integer const &x) const
+{
+	std::vector<big_integer> rems(1, x % product());
+	if (rems[0] < 0) {
+		rems[0] += product();
+	}
+	for (size_t l = tree.size() - 1; l-- != 0;) {
+		std::vector<big_integer> const &level = tree[l];
+		std::vector<big_integer> next(level.size());
+		for (size_t i = 0; i != level.size(); ++i) {
+			next[i] = rems[i / 2] % level[i];
+		}
+		rems = std::move(next);
+	}
+	for (size_t i = 0; i != moduli.size(); ++i) {
+		r[i] = mont_mul(rems[i].get_chunk(0), scales[i], moduli[i], inverses[i]);
+	}
+}
+
+std::vector<uint> rns_context::to_rns(big_integer const &x) const
+{
+	std::vector<uint> res(size());
+	to_rns(res.data(), x);
+	return res;
+}
+
+big_integer rns_context::from_rns(uint const *r) const
+{
+	// x = sum of c_i P / p_i mod P with c_i = r_i (P / p_i)^-1 mod p_i; the
+	// sum is built up the tree, node = left * right's product + right * left's
+	std::vector<big_integer> sums;
+	for (size_t i = 0; i != moduli.size(); ++i) {
+		// mont_mul removes the 2^32 of the residue
+		sums.push_back(big_integer(mont_mul(r[i], weights[i], moduli[i], inverses[i])));
+	}
+	for (size_t l = 0; l + 1 != tree.size(); ++l) {
+		std::vector<big_integer> const &level = tree[l];
+		std::vector<big_integer> next;
+		for (size_t i = 0; i < level.size(); i += 2) {
+			next.push_back((i + 1 < level.size()) ? sums[i] * level[i + 1] + sums[i + 1] * level[i] : sums[i]);
+		}
+		sums = std::move(next);
+	}
+	return sums[0] % product();
+}
+
+big_integer rns_context::from_rns(std::vector<uint> const &r) const
+{
+	return from_rns(r.data());
+}
+
+bool rns_context::simd_active()
+{
+#ifdef HAVE_X86_SIMD
+	return simd_enabled.load(std::memory_order_relaxed) && cpu::has_avx2();
+#else
+	return false;
+#endif
+}
+
+bool rns_context::select_simd(bool use)
+{
+	simd_enabled.store(use, std::memory_order_relaxed);
+	return simd_active();
+}
+
+void rns_context::add(uint *r, uint const *a, uint const *b, size_t count) const
+{
+#ifdef HAVE_X86_SIMD
+	if (simd_active()) {
+		add_avx2(r, a, b, count, moduli.data(), size());
+		return;
+	}
+#endif
+	add_scalar(r, a, b, count, moduli.data(), size());
+}
+
+void rns_context::sub(uint *r, uint const *a, uint const *b, size_t count) const
+{
+#ifdef HAVE_X86_SIMD
+	if (simd_active()) {
+		sub_avx2(r, a, b, count, moduli.data(), size());
+		return;
+	}
+#endif
+	sub_scalar(r, a, b, count, moduli.data(), size());
+}
+
+void rns_context::mul(uint *r, uint const *a, uint const *b, size_t count) const
+{
+#ifdef HAVE_X86_SIMD
+	if (simd_active()) {
+		mul_avx2(r, a, b, count, moduli.data(), inverses.data(), size());
+		return;
+	}
+#endif
+	mul_scalar(r, a, b, count, moduli.data(), inverses.data(), size());
+}
@@ -0,0 +1,69 @@
+#ifndef BIG_INTEGER_RNS_H
+#define BIG_INTEGER_RNS_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Residue number system: a number x is held as its residues x mod p for
+// size() primes p below 2^31, so addition, subtraction and multiplication
+// act on every residue independently (8 at a time with AVX2). Everything is
+// modulo the product P of the primes; a result below P, at least 2^bits, is
+// exact. For products modulo some M, take bits = 2 log2 M and reduce the
+// converted result.
+//
+// Residues are stored scaled by 2^32 (Montgomery form) and only mean
+// something to the context that made them.
+class rns_context {
+public:
+	using uint = std::uint32_t;
+
+	// at least bits bits; the number of primes is a multiple of 8
+	explicit rns_context(size_t bits);
+
+	size_t size() const {
+		return moduli.size();
+	}
+
+	uint modulus(size_t i) const {
+		return moduli[i];
+	}
+
+	// P
+	big_integer const &product() const {
+		return tree.back()[0];
+	}
+
+	// r[0, size()) = the residues of x mod P, x may be negative (remainder tree)
+	void to_rns(uint *r, big_integer const &x) const;
+	std::vector<uint> to_rns(big_integer const &x) const;
+	// the number in [0, P) with residues r[0, size()) (CRT, product tree)
+	big_integer from_rns(uint const *r) const;
+	big_integer from_rns(std::vector<uint> const &r) const;
+
+	// the AVX2 kernels below are in use: the CPU has AVX2 and select_simd did not turn them off
+	static bool simd_active();
+	// turns the AVX2 kernels on or off, returns simd_active()
+	static bool select_simd(bool use);
+
+	// count numbers of size() residues each, one after another; r may alias a or b
+	void add(uint *r, uint const *a, uint const *b, size_t count = 1) const;
+	void sub(uint *r, uint const *a, uint const *b, size_t count = 1) const;
+	void mul(uint *r, uint const *a, uint const *b, size_t count = 1) const;
+
+private:
+	std::vector<uint> moduli;
+	// -p^-1 mod 2^32
+	std::vector<uint> inverses;
+	// 2^64 mod p, scales a residue into Montgomery form
+	std::vector<uint> scales;
+	// (P / p)^-1 mod p, the CRT weights
+	std::vector<uint> weights;
+	// tree[0] are the primes, tree[l + 1][i] = tree[l][2 i] * tree[l][2 i + 1]
+	// (the last one alone when tree[l] has odd size), tree.back()[0] = P
+	std::vector<std::vector<big_integer>> tree;
+};
+
+#endif // BIG_INTEGER_RNS_H
@@ -0,0 +1,138 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "roots.h"
+
+#include <stdexcept>
+
+using uint = std::uint32_t;
+using ull = std::uint64_t;
+
+extern const uint CHUNK_BIT_SIZE;
+
+static uint sqrt_rem_64(ull value, ull &rem)
+{
+	ull root = 0;
+	for (int bit = 31; bit >= 0; --bit) {
+		ull candidate = root | (1ull << bit);
+		if (candidate * candidate <= value) {
+			root = candidate;
+		}
+	}
+	rem = value - root * root;
+	return (uint)root;
+}
+
+// Zimmermann's Karatsuba square root.
+// a has at most 2n chunks and is normalized: a >= BASE^(2n) / 4
+static big_integer dc_sqrt_rem(big_integer const &a, size_t n, big_integer &rem)
+{
+	if (n == 1) {
+		ull value = a.get_chunk(0);
+		if (a.get_data_size() > 1) {
+			value |= (ull)a.get_chunk(1) << CHUNK_BIT_SIZE;
+		}
+		ull r;
+		uint s = sqrt_rem_64(value, r);
+		rem = big_integer(r);
+		return big_integer(s);
+	}
+
+	size_t low = n / 2, high = n - low;
+	int low_bits = (int)(low * CHUNK_BIT_SIZE);
+
+	big_integer high_rem;
+	big_integer high_root = dc_sqrt_rem(a.get_chunks(2 * low, 2 * n), high, high_rem);
+
+	big_integer numerator = (high_rem << low_bits) + a.get_chunks(low, 2 * low);
+	big_integer denominator = high_root << 1;
+	big_integer quotient = numerator / denominator;
+	big_integer u = numerator - quotient * denominator;
+
+	big_integer root = (high_root << low_bits) + quotient;
+	rem = (u << low_bits) + a.get_chunks(0, low) - quotient * quotient;
+	while (rem.signum < 0) {
+		rem += root + root - 1;
+		--root;
+	}
+	return root;
+}
+
+big_integer isqrt(big_integer const &n)
+{
+	big_integer rem;
+	return isqrt_rem(n, rem);
+}
+
+big_integer isqrt_rem(big_integer const &n, big_integer &rem)
+{
+	if (n.signum < 0) {
+		throw std::runtime_error("square root of negative number");
+	}
+	else if (n.signum == 0) {
+		rem = 0;
+		return 0;
+	}
+
+	// shift by an even amount so that the top chunk pair is normalized
+	size_t len = n.bit_length();
+	size_t root_chunks = (len + 2 * CHUNK_BIT_SIZE - 1) / (2 * CHUNK_BIT_SIZE);
+	int shift = (int)(root_chunks * 2 * CHUNK_BIT_SIZE - len) & ~1;
+
+	big_integer root = dc_sqrt_rem(n << shift, root_chunks, rem);
+	if (shift != 0) {
+		root >>= shift / 2;
+		rem = n - root * root;
+	}
+	return root;
+}
+
+// Newton iteration from an overestimate obtained by recursing on the top bits,
+// so every level works with roughly twice as many bits as the previous one
+static big_integer newton_root(big_integer const &n, unsigned k)
+{
+	size_t len = n.bit_length();
+	if (len <= k) {
+		return 1;
+	}
+
+	size_t shift = len / k / 2;
+	if (shift == 0) {
+		uint root = 1;
+		while (pow(big_integer(root + 1), k) <= n) {
+			++root;
+		}
+		return root;
+	}
+
+	big_integer top_root = newton_root(n >> (int)(k * shift), k);
+	big_integer x = (top_root + 1) << (int)shift;
+	big_integer k_val(k), k_minus_1(k - 1);
+	while (true) {
+		big_integer y = (k_minus_1 * x + n / pow(x, k - 1)) / k_val;
+		if (y >= x) {
+			break;
+		}
+		x = y;
+	}
+	return x;
+}
+
+big_integer iroot(big_integer const &n, unsigned k)
+{
+	if (k == 0) {
+		throw std::runtime_error("zeroth root");
+	}
+	else if (n.signum < 0) {
+		if (k % 2 == 0) {
+			throw std::runtime_error("even root of negative number");
+		}
+		return -iroot(-n, k);
+	}
+	else if (k == 1 || n.signum == 0) {
+		return n;
+	}
+	else if (k == 2) {
+		return isqrt(n);
+	}
+	return newton_root(n, k);
+}
@@ -0,0 +1,15 @@
+#ifndef BIG_INTEGER_ROOTS_H
+#define BIG_INTEGER_ROOTS_H
+
+#include "big_integer.h"
+
+// floor(sqrt(n)), n >= 0
+big_integer isqrt(big_integer const &n);
+
+// floor(sqrt(n)), rem = n - root^2
+big_integer isqrt_rem(big_integer const &n, big_integer &rem);
+
+// floor(n^(1/k)), truncated towards zero for negative n and odd k
+big_integer iroot(big_integer const &n, unsigned k);
+
+#endif // BIG_INTEGER_ROOTS_H
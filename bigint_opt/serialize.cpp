@@ -0,0 +1,254 @@
+#define _SCL_SECURE_NO_WARNINGS
+
+#include "serialize.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using uint = std::uint32_t;
+using std::uint8_t;
+
+namespace serial_detail {
+	void assign(big_integer &x, my_vector chunks, bool negative)
+	{
+		x.assign_magnitude(chunks);
+		if (negative) {
+			x.negate();
+		}
+	}
+}
+
+namespace {
+	constexpr size_t CHUNK_BYTES = sizeof(uint);
+	// largest varint of a size_t
+	constexpr size_t MAX_VARINT_BYTES = (8 * sizeof(size_t) + 6) / 7;
+
+	bool little_endian()
+	{
+		uint one = 1;
+		uint8_t first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	size_t varint_size(size_t n)
+	{
+		size_t res = 1;
+		for (; n >= 0x80; n >>= 7) {
+			++res;
+		}
+		return res;
+	}
+
+	// sign byte and varint, padded to whole chunks
+	size_t header_size(size_t n)
+	{
+		return (1 + varint_size(n) + CHUNK_BYTES - 1) / CHUNK_BYTES * CHUNK_BYTES;
+	}
+
+	size_t chunk_count(big_integer const &x)
+	{
+		return (x.signum == 0) ? 0 : x.get_data_size();
+	}
+
+	// byte k of the little-endian magnitude a of n chunks, 0 above it
+	uint8_t magnitude_byte(uint const *a, size_t n, size_t k)
+	{
+		size_t i = k / CHUNK_BYTES;
+		return (i < n) ? (uint8_t)(a[i] >> (8 * (k % CHUNK_BYTES))) : 0;
+	}
+
+	void check_format(int order, size_t size, int endian)
+	{
+		if ((order != 1 && order != -1) || size == 0 || endian < -1 || endian > 1) {
+			throw std::runtime_error("invalid word format");
+		}
+	}
+
+	// where byte j (from the least significant) of word i (likewise) of count
+	// words goes
+	size_t byte_position(size_t i, size_t j, size_t count, int order, size_t size, bool little)
+	{
+		size_t word = (order < 0) ? i : count - 1 - i;
+		return word * size + (little ? j : size - 1 - j);
+	}
+
+	struct record {
+		bool negative;
+		size_t n;
+		uint8_t const *chunks;
+		uint8_t const *end;
+	};
+
+	record read_record(uint8_t const *first, uint8_t const *last)
+	{
+		size_t available = (size_t)(last - first);
+		if (available == 0 || first[0] > 1) {
+			throw std::runtime_error(available == 0 ? "truncated record" : "invalid sign byte");
+		}
+
+		record res;
+		res.negative = first[0] == 1;
+		res.n = 0;
+		size_t pos = 1;
+		for (unsigned shift = 0;; shift += 7) {
+			if (pos == available || pos > MAX_VARINT_BYTES) {
+				throw std::runtime_error(pos == available ? "truncated record" : "invalid length");
+			}
+			uint8_t byte = first[pos++];
+			res.n |= (size_t)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				break;
+			}
+		}
+
+		// the shortest varint only, so that the header size follows from n
+		if (pos != 1 + varint_size(res.n)) {
+			throw std::runtime_error("invalid length");
+		}
+		size_t header = header_size(res.n);
+		if (header > available || res.n > (available - header) / CHUNK_BYTES) {
+			throw std::runtime_error("truncated record");
+		}
+		res.chunks = first + header;
+		res.end = res.chunks + res.n * CHUNK_BYTES;
+		if (res.n == 0 ? res.negative : (res.end[-1] == 0 && res.end[-2] == 0 && res.end[-3] == 0 && res.end[-4] == 0)) {
+			throw std::runtime_error("invalid record");
+		}
+		return res;
+	}
+}
+
+size_t serialized_size(big_integer const &x)
+{
+	size_t n = chunk_count(x);
+	return header_size(n) + n * CHUNK_BYTES;
+}
+
+uint8_t *serialize(big_integer const &x, uint8_t *out)
+{
+	size_t n = chunk_count(x);
+	size_t header = header_size(n);
+	std::fill(out, out + header, 0);
+	out[0] = (x.signum < 0) ? 1 : 0;
+	size_t pos = 1;
+	for (size_t rest = n; rest >= 0x80; rest >>= 7) {
+		out[pos++] = (uint8_t)(rest | 0x80);
+	}
+	out[pos] = (uint8_t)(n >> (7 * (pos - 1)));
+	out += header;
+
+	my_vector const data = x.get_data();
+	if (little_endian()) {
+		std::memcpy(out, data.begin(), n * CHUNK_BYTES);
+	}
+	else {
+		for (size_t k = 0; k != n * CHUNK_BYTES; ++k) {
+			out[k] = magnitude_byte(data.begin(), n, k);
+		}
+	}
+	return out + n * CHUNK_BYTES;
+}
+
+std::vector<uint8_t> serialize(big_integer const &x)
+{
+	std::vector<uint8_t> res(serialized_size(x));
+	serialize(x, res.data());
+	return res;
+}
+
+uint8_t const *deserialize(big_integer &x, uint8_t const *first, uint8_t const *last)
+{
+	record r = read_record(first, last);
+	my_vector chunks(std::max<size_t>(r.n, 1));
+	uint *out = chunks.begin();
+	if (little_endian()) {
+		std::memcpy(out, r.chunks, r.n * CHUNK_BYTES);
+	}
+	else {
+		for (size_t i = 0; i != r.n; ++i) {
+			uint8_t const *in = r.chunks + i * CHUNK_BYTES;
+			out[i] = (uint)in[0] | ((uint)in[1] << 8) | ((uint)in[2] << 16) | ((uint)in[3] << 24);
+		}
+	}
+	serial_detail::assign(x, chunks, r.negative);
+	return r.end;
+}
+
+big_integer deserialize(std::vector<uint8_t> const &bytes)
+{
+	big_integer res;
+	if (deserialize(res, bytes.data(), bytes.data() + bytes.size()) != bytes.data() + bytes.size()) {
+		throw std::runtime_error("trailing bytes after record");
+	}
+	return res;
+}
+
+uint8_t const *deserialize(big_integer &x, uint8_t const *first, uint8_t const *last,
+	std::shared_ptr<void const> owner)
+{
+	record r = read_record(first, last);
+	if (r.n == 0 || !little_endian() || reinterpret_cast<std::uintptr_t>(r.chunks) % alignof(uint) != 0) {
+		return deserialize(x, first, last);
+	}
+	serial_detail::assign(x, my_vector::adopt(std::move(owner), reinterpret_cast<uint const *>(r.chunks), r.n), r.negative);
+	return r.end;
+}
+
+size_t export_size(big_integer const &x, size_t size)
+{
+	if (size == 0) {
+		throw std::runtime_error("invalid word format");
+	}
+	return ((x.bit_length() + 7) / 8 + size - 1) / size;
+}
+
+size_t export_words(void *out, int order, size_t size, int endian, big_integer const &x)
+{
+	check_format(order, size, endian);
+	size_t count = export_size(x, size);
+	my_vector const data = x.get_data();
+	uint8_t *res = static_cast<uint8_t *>(out);
+	bool little = (endian == 0) ? little_endian() : endian < 0;
+
+	if (order < 0 && little && little_endian()) {
+		// the bytes are in memory order already
+		size_t bytes = std::min(count * size, data.size() * CHUNK_BYTES);
+		std::memcpy(res, data.begin(), bytes);
+		std::fill(res + bytes, res + count * size, 0);
+		return count;
+	}
+	for (size_t i = 0; i != count; ++i) {
+		for (size_t j = 0; j != size; ++j) {
+			res[byte_position(i, j, count, order, size, little)] = magnitude_byte(data.begin(), data.size(), i * size + j);
+		}
+	}
+	return count;
+}
+
+big_integer import_words(void const *in, size_t count, int order, size_t size, int endian)
+{
+	check_format(order, size, endian);
+	uint8_t const *src = static_cast<uint8_t const *>(in);
+	bool little = (endian == 0) ? little_endian() : endian < 0;
+	size_t bytes = count * size;
+	my_vector chunks(std::max<size_t>((bytes + CHUNK_BYTES - 1) / CHUNK_BYTES, 1));
+	uint *out = chunks.begin();
+
+	if (order < 0 && little && little_endian()) {
+		std::memcpy(out, src, bytes);
+	}
+	else {
+		for (size_t i = 0; i != count; ++i) {
+			for (size_t j = 0; j != size; ++j) {
+				size_t k = i * size + j;
+				out[k / CHUNK_BYTES] |= (uint)src[byte_position(i, j, count, order, size, little)] << (8 * (k % CHUNK_BYTES));
+			}
+		}
+	}
+
+	big_integer res;
+	serial_detail::assign(res, chunks, false);
+	return res;
+}
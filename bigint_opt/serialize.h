@@ -0,0 +1,43 @@
+#ifndef BIG_INTEGER_SERIALIZE_H
+#define BIG_INTEGER_SERIALIZE_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Binary records: a sign byte (1 for negative, else 0), the number of chunks
+// of |x| as an unsigned LEB128 varint (0 for x = 0), zero bytes up to a
+// multiple of 4, then the chunks from the least significant one, 4 bytes
+// each, little-endian. Records keep 4-byte alignment, so the chunks of a
+// record in an aligned buffer can be used in place on little-endian machines.
+
+size_t serialized_size(big_integer const &x);
+// writes serialized_size(x) bytes at out, returns the end
+std::uint8_t *serialize(big_integer const &x, std::uint8_t *out);
+std::vector<std::uint8_t> serialize(big_integer const &x);
+
+// reads the record at first into x, returns its end; a truncated or malformed
+// record (bad sign byte, leading zero chunk) throws
+std::uint8_t const *deserialize(big_integer &x, std::uint8_t const *first, std::uint8_t const *last);
+big_integer deserialize(std::vector<std::uint8_t> const &bytes);
+// the same, but x points at the chunks in the buffer instead of copying them
+// when they are aligned and the machine is little-endian; owner keeps the
+// buffer alive, and the first change to x copies them
+std::uint8_t const *deserialize(big_integer &x, std::uint8_t const *first, std::uint8_t const *last,
+	std::shared_ptr<void const> owner);
+
+// |x| as words of size bytes, as GMP's mpz_export and mpz_import: order 1
+// puts the most significant word first and -1 the least significant one,
+// endian 1 orders the bytes of a word big-endian, -1 little-endian and 0 as
+// the machine does; other values throw. The sign is not stored.
+
+// number of words of |x|, 0 for x = 0
+size_t export_size(big_integer const &x, size_t size);
+// writes export_size(x, size) words at out, returns their number
+size_t export_words(void *out, int order, size_t size, int endian, big_integer const &x);
+big_integer import_words(void const *in, size_t count, int order, size_t size, int endian);
+
+#endif // BIG_INTEGER_SERIALIZE_H
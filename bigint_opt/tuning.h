@@ -0,0 +1,92 @@
+#ifndef OPTS_TUNING_H
+#define OPTS_TUNING_H
+
+// Algorithm crossover points, in chunks.
+// The tune program measures them on the build machine and writes
+// bigint_opt_thresholds.h; when that header is next to this one (or anywhere
+// on the include path) its values replace the defaults below.
+
+#if defined(__has_include)
+#if __has_include("bigint_opt_thresholds.h")
+#include "bigint_opt_thresholds.h"
+#endif
+#endif
+
+#ifdef TUNE_PROGRAM_BUILD
+
+// the tune program links its own copy of the library with run-time thresholds
+#include <cstddef>
+
+namespace tuning {
+	extern size_t karatsuba_mul_threshold;
+	extern size_t karatsuba_sqr_threshold;
+	extern size_t dc_conversion_threshold;
+}
+
+#undef KARATSUBA_MUL_THRESHOLD
+#undef KARATSUBA_SQR_THRESHOLD
+#undef DC_CONVERSION_THRESHOLD
+#define KARATSUBA_MUL_THRESHOLD (tuning::karatsuba_mul_threshold)
+#define KARATSUBA_SQR_THRESHOLD (tuning::karatsuba_sqr_threshold)
+#define DC_CONVERSION_THRESHOLD (tuning::dc_conversion_threshold)
+
+#else
+
+// operands below this use schoolbook multiplication
+#ifndef KARATSUBA_MUL_THRESHOLD
+#define KARATSUBA_MUL_THRESHOLD 32
+#endif
+
+// as KARATSUBA_MUL_THRESHOLD, for squaring
+#ifndef KARATSUBA_SQR_THRESHOLD
+#define KARATSUBA_SQR_THRESHOLD 48
+#endif
+
+// numbers up to this size are converted to and from decimal chunk by chunk,
+// larger ones are split by powers of 10^9
+#ifndef DC_CONVERSION_THRESHOLD
+#define DC_CONVERSION_THRESHOLD 40
+#endif
+
+#endif // TUNE_PROGRAM_BUILD
+
+// products with both operands at least this size are split across threads
+// when a parallel::policy allows more than one; not measured by tune
+#ifndef PARALLEL_MUL_THRESHOLD
+#define PARALLEL_MUL_THRESHOLD 2048
+#endif
+
+// as PARALLEL_MUL_THRESHOLD, for the halves of a decimal conversion split
+#ifndef PARALLEL_CONVERSION_THRESHOLD
+#define PARALLEL_CONVERSION_THRESHOLD 2048
+#endif
+
+// multi_mod with word-sized moduli divides x by every group of moduli in one
+// pass below this size of x, and from it on goes through a remainder tree down
+// to nodes of MULTI_MOD_LEAF_GROUPS groups (chunks); not measured by tune
+#ifndef MULTI_MOD_TREE_THRESHOLD
+#define MULTI_MOD_TREE_THRESHOLD 48
+#endif
+
+#ifndef MULTI_MOD_LEAF_GROUPS
+#define MULTI_MOD_LEAF_GROUPS 16
+#endif
+
+// with AVX-512 IFMA (see ifma.h), products of operands of IFMA_MUL_THRESHOLD
+// to IFMA_MUL_LIMIT chunks, including the Karatsuba subproducts in that range,
+// use the 52-bit kernel; not measured by tune
+#ifndef IFMA_MUL_THRESHOLD
+#define IFMA_MUL_THRESHOLD 20
+#endif
+
+#ifndef IFMA_MUL_LIMIT
+#define IFMA_MUL_LIMIT 1024
+#endif
+
+// as IFMA_MUL_THRESHOLD, for Montgomery products in the prime tests; larger
+// moduli use it up to ifma::MONT_LIMIT
+#ifndef IFMA_MONT_THRESHOLD
+#define IFMA_MONT_THRESHOLD 4
+#endif
+
+#endif // OPTS_TUNING_H
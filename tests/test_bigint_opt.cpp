@@ -0,0 +1,833 @@
+// Checks the bigint_opt entry points against the operators and scalar kernels
+// they replace, on random operands. Prints every failed check and exits with 1
+// if there was one.
+
+#include "accumulator.h"
+#include "batch.h"
+#include "big_integer.h"
+#include "combinatorics.h"
+#include "expression.h"
+#include "fixed_big_integer.h"
+#include "ifma.h"
+#include "limbs.h"
+#include "mapped_array.h"
+#include "multi_mod.h"
+#include "parallel.h"
+#include "primes.h"
+#include "rns.h"
+#include "roots.h"
+#include "serialize.h"
+#include "tuning.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using namespace fixed_literals;
+
+	constexpr fixed_uint<128> TWO_64 = fixed_uint<128>(1) << 64;
+	static_assert(TWO_64 + TWO_64 == fixed_uint<128>(1) << 65, "fixed +");
+	static_assert(fixed_uint<64>(0) - 1 == ~fixed_uint<64>(0), "fixed - wraps around");
+	static_assert((TWO_64 - 1) * (TWO_64 - 1) == 1 - (TWO_64 << 1), "fixed * wraps around");
+	static_assert((TWO_64 + 7) / 3 == 6148914691236517207ull, "fixed /");
+	static_assert((TWO_64 + 7) % 3 == 2, "fixed %");
+	static_assert(TWO_64 * TWO_64 / (TWO_64 + 1) == 0, "fixed / of a wrapped product");
+	static_assert((TWO_64 >> 63) == 2 && (TWO_64 << 64) == 0, "fixed << and >>");
+	static_assert(fixed_int<128>(-7) / fixed_int<128>(2) == -3 && fixed_int<128>(-7) % fixed_int<128>(2) == -1, "signed / and %");
+	static_assert(fixed_int<128>(7) / fixed_int<128>(-2) == -3 && fixed_int<128>(7) % fixed_int<128>(-2) == 1, "signed / and %");
+	static_assert((fixed_int<96>(-8) >> 1) == -4 && (fixed_int<96>(-1) >> 95) == -1, "signed >>");
+	static_assert(fixed_int<64>(-1) < fixed_int<64>(0) && fixed_uint<64>(0) < fixed_uint<64>(-1), "comparison");
+
+	static_assert(123456789012345678901234567890_bi == fixed_uint<128>(1234567890123456789ull) * 100000000000ull + 1234567890, "decimal _bi");
+	static_assert((123456789012345678901234567890_bi).CHUNKS == 4, "_bi width");
+	static_assert(0xFFFF'FFFF'FFFF'FFFF'FFFF_bi == (fixed_uint<96>(1) << 80) - 1, "hexadecimal _bi");
+	static_assert((0xFFFF'FFFF'FFFF'FFFF'FFFF_bi).CHUNKS == 3, "_bi width");
+	static_assert(0b1011_bi == 11 && (0B1'0000'0000'0000'0000'0000'0000'0000'0000_bi).CHUNKS == 2, "binary _bi");
+	static_assert(0777_bi == 511 && 0_bi == 0 && (0_bi).CHUNKS == 1, "octal _bi");
+	static_assert(fixed_uint<64>(1000000007_bi) * fixed_uint<64>(1000000009_bi) % 1000000007 == 0, "_bi arithmetic");
+}
+
+namespace {
+	using uint = std::uint32_t;
+
+	std::mt19937 rng(20240229);
+	size_t failures = 0;
+
+	void check(bool ok, std::string const &what) {
+		if (!ok) {
+			++failures;
+			std::cout << "FAILED: " << what << "\n";
+		}
+	}
+
+	// number with exactly limbs 32-bit chunks
+	big_integer random_number(size_t limbs) {
+		big_integer res = 0;
+		for (size_t i = 0; i != limbs; ++i) {
+			res = (res << 32) + big_integer(static_cast<uint>(rng() | (i == 0 ? 1u : 0u)));
+		}
+		return res;
+	}
+
+	// up to limbs chunks, often with trailing zero bits, either sign
+	big_integer random_signed(size_t limbs) {
+		big_integer res = random_number(1 + rng() % limbs);
+		if (rng() % 2 == 0) {
+			res <<= static_cast<int>(rng() % 100);
+		}
+		return (rng() % 2 == 0) ? -res : res;
+	}
+
+	// the number with little-endian chunks a
+	big_integer from_chunks(std::vector<uint> const &a) {
+		big_integer res = 0;
+		for (size_t i = a.size(); i--;) {
+			res = (res << 32) + big_integer(a[i]);
+		}
+		return res;
+	}
+
+	void test_roots() {
+		for (size_t limbs : {1, 2, 5, 20, 80}) {
+			for (int it = 0; it != 20; ++it) {
+				big_integer n = random_number(1 + rng() % limbs);
+				std::string what = "isqrt/iroot, " + std::to_string(limbs) + " chunks";
+
+				big_integer rem;
+				big_integer r = isqrt_rem(n, rem);
+				check(r == isqrt(n), what);
+				check(rem == n - r * r && rem >= 0 && n < (r + 1) * (r + 1), what);
+
+				unsigned k = 2 + rng() % 6;
+				r = iroot(n, k);
+				big_integer power = 1, next = 1;
+				for (unsigned i = 0; i != k; ++i) {
+					power *= r;
+					next *= r + 1;
+				}
+				check(power <= n && n < next, what);
+				if (k % 2 == 1) {
+					check(iroot(-n, k) == -r, what);
+				}
+			}
+		}
+		check(isqrt(big_integer(0)) == 0 && iroot(big_integer(1), 5) == 1, "isqrt(0), iroot(1, 5)");
+	}
+
+	void test_combinatorics() {
+		big_integer expected = 1;
+		for (unsigned n = 0; n <= 1500; ++n) {
+			if (n != 0) {
+				expected *= big_integer(n);
+			}
+			if (n < 40 || n % 101 == 0) {
+				check(factorial(n) == expected, "factorial(" + std::to_string(n) + ")");
+			}
+		}
+
+		// Pascal's triangle
+		std::vector<big_integer> row = {1};
+		for (unsigned n = 0; n <= 300; ++n) {
+			if (n < 40 || n % 50 == 0) {
+				for (unsigned k = 0; k <= n + 2; ++k) {
+					check(binomial(n, k) == (k <= n ? row[k] : big_integer(0)),
+						"binomial(" + std::to_string(n) + ", " + std::to_string(k) + ")");
+				}
+			}
+			std::vector<big_integer> next(n + 2, 1);
+			for (unsigned k = 1; k <= n; ++k) {
+				next[k] = row[k - 1] + row[k];
+			}
+			row = next;
+		}
+		big_integer half = factorial(1000);
+		check(binomial(2000, 1000) == factorial(2000) / (half * half), "binomial(2000, 1000)");
+
+		expected = 1;
+		for (unsigned n = 2; n <= 5000; ++n) {
+			bool prime = true;
+			for (unsigned d = 2; d * d <= n && prime; ++d) {
+				prime = n % d != 0;
+			}
+			if (prime) {
+				expected *= big_integer(n);
+			}
+			if (n < 40 || n % 499 == 0) {
+				check(primorial(n) == expected, "primorial(" + std::to_string(n) + ")");
+			}
+		}
+		check(primorial(0) == 1 && primorial(1) == 1, "primorial(0), primorial(1)");
+	}
+
+	void test_pow() {
+		for (size_t limbs : {1, 2, 4}) {
+			for (int it = 0; it != 20; ++it) {
+				big_integer base = random_signed(limbs);
+				big_integer expected = 1;
+				for (unsigned e = 0; e <= 70; ++e) {
+					check(pow(base, e) == expected, "pow, exponent " + std::to_string(e));
+					expected *= base;
+				}
+			}
+		}
+
+		big_integer expected = 1;
+		for (int e = 0; e != 3000; ++e) {
+			expected *= 3;
+		}
+		check(pow(big_integer(3), 3000) == expected, "pow(3, 3000)");
+		check(pow(big_integer(-2), 1001) == -(big_integer(1) << 1001), "pow(-2, 1001)");
+		check(pow(big_integer(0), 0) == 1 && pow(big_integer(0), 5) == 0, "pow of 0");
+		check(pow(big_integer(-1), 1ull << 40) == 1 && pow(big_integer(1), ~0ull) == 1, "pow of 1 and -1");
+	}
+
+	void test_primes() {
+		uint const LIMIT = 30000;
+		std::vector<bool> composite(LIMIT + 1);
+		std::vector<uint> expected;
+		for (uint n = 2; n <= LIMIT; ++n) {
+			if (!composite[n]) {
+				expected.push_back(n);
+				for (uint m = 2 * n; m <= LIMIT; m += n) {
+					composite[m] = true;
+				}
+			}
+		}
+		check(primes_up_to(LIMIT) == expected, "primes_up_to");
+		for (uint n = 0; n <= LIMIT; ++n) {
+			check(is_probable_prime(big_integer(n)) == (n >= 2 && !composite[n]), "is_probable_prime(" + std::to_string(n) + ")");
+		}
+		for (size_t i = 0; i + 1 != expected.size(); ++i) {
+			check(next_prime(big_integer(expected[i])) == expected[i + 1], "next_prime(" + std::to_string(expected[i]) + ")");
+		}
+		for (int n : {-1000, -7, -2, -1, 0, 1}) {
+			check(!is_probable_prime(big_integer(n)) && next_prime(big_integer(n)) == 2, "primes at " + std::to_string(n));
+		}
+		check(next_prime(big_integer(2)) == 3, "next_prime(2)");
+
+		// 2^p - 1 is prime for these p, and 2^p + 1 is divisible by 3 for odd p
+		for (unsigned p : {2, 3, 5, 7, 13, 17, 19, 31, 61, 89, 107, 127, 521, 607, 1279}) {
+			big_integer m = (big_integer(1) << static_cast<int>(p)) - 1;
+			std::string what = "Mersenne prime 2^" + std::to_string(p) + " - 1";
+			check(is_probable_prime(m) && is_probable_prime(m, 5), what);
+			check(next_prime(m - 1) == m && next_prime(m) > m + 1, what);
+			check(p == 2 || !is_probable_prime(m + 2), what + " + 2");
+		}
+		for (unsigned p : {11, 23, 29, 37, 41, 43, 47, 53, 59, 67, 257}) {
+			check(!is_probable_prime((big_integer(1) << static_cast<int>(p)) - 1), "2^" + std::to_string(p) + " - 1");
+		}
+
+		// Carmichael numbers and strong pseudoprimes to the first prime bases
+		for (char const *n : {"561", "1105", "1729", "2465", "2821", "6601", "8911", "2047", "1373653", "25326001",
+			"3215031751", "2152302898747", "3474749660383", "341550071728321", "3825123056546413051",
+			"318665857834031151167461"}) {
+			check(!is_probable_prime(big_integer(n)), std::string("pseudoprime ") + n);
+		}
+		big_integer m61 = (big_integer(1) << 61) - 1, m89 = (big_integer(1) << 89) - 1, m127 = (big_integer(1) << 127) - 1;
+		check(!is_probable_prime(m61 * m89) && !is_probable_prime(m127 * m127) && !is_probable_prime(m89 * m127 * m61),
+			"products of Mersenne primes");
+
+		check(next_prime(big_integer(1) << 32) == (big_integer(1) << 32) + 15, "next_prime(2^32)");
+		check(next_prime(big_integer(1) << 64) == (big_integer(1) << 64) + 13, "next_prime(2^64)");
+	}
+
+	void test_bits() {
+		for (size_t limbs : {1, 2, 5}) {
+			for (int it = 0; it != 40; ++it) {
+				big_integer x = random_signed(limbs);
+				big_integer magnitude = (x < 0) ? -x : x;
+				std::string what = "bit operations, " + std::to_string(limbs) + " chunks";
+
+				size_t length = x.bit_length(), ones = 0;
+				check((magnitude >> static_cast<int>(length)) == 0 && (magnitude >> static_cast<int>(length - 1)) == 1, what + " bit_length");
+				for (size_t bit = 0; bit != length; ++bit) {
+					ones += ((magnitude >> static_cast<int>(bit)) & 1) == 1;
+				}
+				check(x.popcount() == ones, what + " popcount");
+				size_t zeros = x.ctz();
+				check((magnitude >> static_cast<int>(zeros)) << static_cast<int>(zeros) == magnitude
+					&& ((magnitude >> static_cast<int>(zeros)) & 1) == 1, what + " ctz");
+
+				for (size_t bit : {size_t(0), size_t(1), zeros, zeros + 1, length - 1, length, length + 40, size_t(rng() % 200)}) {
+					big_integer mask = big_integer(1) << static_cast<int>(bit);
+					big_integer y = x;
+					check(x.test_bit(bit) == ((x & mask) != 0), what + " test_bit");
+					check(y.set_bit(bit) == (x | mask), what + " set_bit");
+					y = x;
+					check(y.clear_bit(bit) == (x & ~mask), what + " clear_bit");
+					y = x;
+					check(y.flip_bit(bit) == (x ^ mask), what + " flip_bit");
+				}
+			}
+		}
+
+		big_integer zero = 0;
+		check(zero.bit_length() == 0 && zero.popcount() == 0 && !zero.test_bit(5), "bit operations on 0");
+		check(zero.set_bit(70) == big_integer(1) << 70 && zero.clear_bit(70) == 0, "set_bit and clear_bit from 0");
+		check(big_integer(-1).test_bit(1000) && big_integer(-1).clear_bit(0) == -2, "bit operations on -1");
+	}
+
+	void test_expressions() {
+		for (size_t limbs : {1, 4, 40, 100}) {
+			for (int it = 0; it != 10; ++it) {
+				big_integer a = random_signed(limbs), b = random_signed(limbs), c = random_signed(limbs);
+				big_integer d = random_signed(limbs), e = random_signed(limbs);
+				std::string what = "expressions, " + std::to_string(limbs) + " chunks";
+
+				check(expr::eval(expr::lazy(a) * b + expr::lazy(c) * d - e) == a * b + c * d - e, what);
+				check(expr::eval(-(expr::lazy(a) - b) * (expr::lazy(c) + 3)) == -(a - b) * (c + 3), what);
+				check(expr::eval(2 * expr::lazy(a) - expr::lazy(b) * 7 + 1) == 2 * a - b * 7 + 1, what);
+				check(expr::eval(expr::lazy(a) * a - expr::lazy(a) * a) == 0, what);
+				check(expr::eval((expr::lazy(a) + b) * (expr::lazy(c) - d) * e) == (a + b) * (c - d) * e, what);
+
+				// the destination as an operand
+				big_integer dest = a;
+				expr::assign(dest, expr::lazy(dest) * b + dest - expr::lazy(c) * dest);
+				check(dest == a * b + a - c * a, what + ", in place");
+			}
+		}
+	}
+
+	void test_addmul() {
+		for (size_t limbs : {1, 3, 40, 100}) {
+			for (int it = 0; it != 20; ++it) {
+				big_integer acc = (it % 5 == 0) ? big_integer(0) : random_signed(limbs + (it % 3) * 30);
+				big_integer a = random_signed(limbs), b = random_signed(limbs);
+				std::uint64_t w = (static_cast<std::uint64_t>(rng()) << 32) | rng();
+				std::string what = "addmul, " + std::to_string(limbs) + " chunks";
+
+				big_integer r = acc;
+				addmul(r, a, b);
+				check(r == acc + a * b, what);
+				r = acc;
+				submul(r, a, b);
+				check(r == acc - a * b, what + " submul");
+				r = acc;
+				addmul_ui(r, a, w);
+				check(r == acc + a * big_integer(w), what + " addmul_ui");
+				r = a * b;
+				submul(r, a, b);
+				check(r == 0, what + " submul to 0");
+			}
+		}
+	}
+
+	void test_accumulator() {
+		big_accumulator acc;
+		big_integer expected = 0;
+		for (int it = 0; it != 2000; ++it) {
+			big_integer x = random_signed(1 + rng() % 20);
+			if (rng() % 3 == 0) {
+				acc -= x;
+				expected -= x;
+			}
+			else {
+				acc += x;
+				expected += x;
+			}
+			if (it % 400 == 0) {
+				check(acc.finalize() == expected, "big_accumulator, finalize on the way");
+			}
+		}
+		check(acc.finalize() == expected, "big_accumulator");
+
+		acc.clear();
+		check(acc.finalize() == 0, "big_accumulator, clear");
+		big_integer x = random_number(30);
+		acc += x;
+		acc -= x;
+		acc -= 1;
+		check(acc.finalize() == -1, "big_accumulator, cancelling terms");
+	}
+
+	void test_fixed() {
+		big_integer modulus = big_integer(1) << 256, half = big_integer(1) << 255;
+		// x mod 2^256 in [-2^255, 2^255)
+		auto wrap = [&](big_integer x) {
+			x %= modulus;
+			x = (x < 0) ? x + modulus : x;
+			return (x >= half) ? x - modulus : x;
+		};
+
+		for (int it = 0; it != 500; ++it) {
+			big_integer x = wrap(random_signed(8)), y = wrap(random_signed(1 + rng() % 8));
+			if (it == 0) {
+				x = -half;
+				y = -1;
+			}
+			fixed_int<256> a(x), b(y);
+			check(a.to_big_integer() == x, "fixed_int<256> from big_integer");
+			check((a / b).to_big_integer() == wrap(x / y), "fixed_int<256> /");
+			check((a % b).to_big_integer() == wrap(x % y), "fixed_int<256> %");
+			check((a * b).to_big_integer() == wrap(x * y) && (a - b).to_big_integer() == wrap(x - y), "fixed_int<256> * and -");
+		}
+	}
+
+	void test_parallel_mul() {
+		size_t n = PARALLEL_MUL_THRESHOLD;
+		big_integer a = random_number(n + 37), b = random_number(n + 5), c = -random_number(3 * n);
+		for (size_t threads : {1, 2, 4}) {
+			std::string what = "mul on " + std::to_string(threads) + " threads";
+			check(mul(a, b, parallel::policy(threads)) == a * b, what);
+			check(mul(c, b, parallel::policy(threads)) == c * b, what + ", unbalanced");
+			check(mul(a, a, parallel::policy(threads)) == a * a, what + ", square");
+		}
+	}
+
+	void test_parallel_conversion() {
+		big_integer x = random_number(PARALLEL_CONVERSION_THRESHOLD + 100);
+		std::string digits = to_string(x);
+		for (size_t threads : {1, 2, 4}) {
+			parallel::policy policy(threads);
+			std::string what = "conversion on " + std::to_string(threads) + " threads";
+			check(to_string(x, policy) == digits && to_string(-x, policy) == "-" + digits, what);
+			check(big_integer(digits, policy) == x && big_integer("-" + digits, policy) == -x, what);
+			check(big_integer(digits + "0123456789", policy) == big_integer(digits + "0123456789"), what);
+		}
+	}
+
+	void test_batch() {
+		batch::kernel const widest = batch::active();
+		for (batch::kernel k : {batch::kernel::scalar, batch::kernel::avx2, batch::kernel::avx512}) {
+			batch::kernel used = batch::select(k);
+			std::string what = std::string("batch, ") + batch::name(used);
+			for (size_t chunks : {1, 3, 8}) {
+				size_t count = 37;
+				big_integer modulus = big_integer(1) << static_cast<int>(32 * chunks);
+				big_integer_batch a(count, chunks), b(count, chunks), r(count, chunks);
+				std::vector<big_integer> x(count), y(count);
+				for (size_t j = 0; j != count; ++j) {
+					x[j] = random_number(1 + rng() % chunks);
+					y[j] = (j % 5 == 0) ? x[j] : random_number(1 + rng() % chunks);
+					a.set(j, x[j]);
+					b.set(j, y[j]);
+				}
+
+				std::vector<uint> carry(count);
+				std::vector<int> order(count);
+				uint m = static_cast<uint>(rng());
+				batch::add(r, a, b, carry.data());
+				for (size_t j = 0; j != count; ++j) {
+					check(r.get(j) == (x[j] + y[j]) % modulus && carry[j] == (x[j] + y[j]) / modulus, what + " add");
+				}
+				batch::sub(r, a, b, carry.data());
+				for (size_t j = 0; j != count; ++j) {
+					big_integer diff = x[j] - y[j];
+					check(r.get(j) == (diff < 0 ? diff + modulus : diff) && carry[j] == (diff < 0 ? 1u : 0u), what + " sub");
+				}
+				batch::mul_1(r, a, m, carry.data());
+				for (size_t j = 0; j != count; ++j) {
+					big_integer prod = x[j] * big_integer(m);
+					check(r.get(j) == prod % modulus && carry[j] == prod / modulus, what + " mul_1");
+				}
+				batch::cmp(order.data(), a, b);
+				for (size_t j = 0; j != count; ++j) {
+					check(order[j] == ((x[j] < y[j]) ? -1 : (x[j] > y[j]) ? 1 : 0), what + " cmp");
+				}
+			}
+		}
+		batch::select(widest);
+	}
+
+	void test_ifma() {
+		if (!ifma::supported()) {
+			std::cout << "ifma: not supported, skipped\n";
+			return;
+		}
+		for (size_t an : {1, 7, 8, 9, 33, 200, 700}) {
+			for (size_t bn : {1, 5, 20, 64}) {
+				if (bn > an) {
+					continue;
+				}
+				std::vector<uint> a(an), b(bn), expected(an + bn), got(an + bn);
+				for (uint &x : a) {
+					x = static_cast<uint>(rng());
+				}
+				for (uint &x : b) {
+					x = static_cast<uint>(rng());
+				}
+				// all-ones operands give the largest column sums
+				if (an == 700) {
+					std::fill(a.begin(), a.end(), ~0u);
+					std::fill(b.begin(), b.end(), ~0u);
+				}
+				limbs::mul_basecase(expected.data(), a.data(), an, b.data(), bn);
+				ifma::mul(got.data(), a.data(), an, b.data(), bn);
+				check(got == expected, "ifma::mul, " + std::to_string(an) + " x " + std::to_string(bn) + " chunks");
+			}
+		}
+
+		// is_probable_prime goes through ifma::montgomery from IFMA_MONT_THRESHOLD chunks
+		big_integer m127 = (big_integer(1) << 127) - 1, m521 = (big_integer(1) << 521) - 1;
+		for (big_integer const &n : {m127, m521, m127 * m521, m521 * m521 + 2, big_integer(1) << 1000}) {
+			bool with_ifma = is_probable_prime(n);
+			ifma::select(false);
+			check(with_ifma == is_probable_prime(n), "is_probable_prime with and without ifma::montgomery");
+			ifma::select(true);
+		}
+	}
+
+	void test_rns() {
+		bool const simd = rns_context::simd_active();
+		for (bool use_simd : {false, true}) {
+			rns_context::select_simd(use_simd);
+			std::string what = std::string("rns, ") + (rns_context::simd_active() ? "AVX2" : "scalar");
+			for (size_t bits : {64, 500, 3000}) {
+				rns_context context(bits);
+				big_integer const &p = context.product();
+				size_t n = context.size();
+				check(n % 8 == 0 && p >= big_integer(1) << static_cast<int>(bits), what + " product");
+
+				size_t count = 5, limbs = bits / 64 + 1;
+				std::vector<big_integer> x(count), y(count);
+				std::vector<uint> a(count * n), b(count * n), r(count * n);
+				for (size_t j = 0; j != count; ++j) {
+					x[j] = random_signed(limbs);
+					y[j] = random_signed(limbs);
+					context.to_rns(a.data() + j * n, x[j]);
+					context.to_rns(b.data() + j * n, y[j]);
+				}
+				// the representative of v in [0, P)
+				auto reduce = [&](big_integer v) {
+					v %= p;
+					return (v < 0) ? v + p : v;
+				};
+
+				for (size_t j = 0; j != count; ++j) {
+					check(context.from_rns(a.data() + j * n) == reduce(x[j]), what + " round trip");
+				}
+				check(context.from_rns(context.to_rns(p + 5)) == 5 && context.from_rns(context.to_rns(-p)) == 0, what + " round trip");
+				context.add(r.data(), a.data(), b.data(), count);
+				for (size_t j = 0; j != count; ++j) {
+					check(context.from_rns(r.data() + j * n) == reduce(x[j] + y[j]), what + " add");
+				}
+				context.sub(r.data(), a.data(), b.data(), count);
+				for (size_t j = 0; j != count; ++j) {
+					check(context.from_rns(r.data() + j * n) == reduce(x[j] - y[j]), what + " sub");
+				}
+				context.mul(r.data(), a.data(), b.data(), count);
+				for (size_t j = 0; j != count; ++j) {
+					check(context.from_rns(r.data() + j * n) == reduce(x[j] * y[j]), what + " mul");
+				}
+				// in place
+				context.mul(a.data(), a.data(), a.data(), count);
+				for (size_t j = 0; j != count; ++j) {
+					check(context.from_rns(a.data() + j * n) == reduce(x[j] * x[j]), what + " mul in place");
+				}
+			}
+		}
+		rns_context::select_simd(simd);
+	}
+
+	void test_multi_mod() {
+		// a few chunks for the multi_mod_1 pass, more for the remainder tree
+		for (size_t limbs : {size_t(1), size_t(3), size_t(MULTI_MOD_TREE_THRESHOLD), size_t(4 * MULTI_MOD_TREE_THRESHOLD)}) {
+			for (size_t count : {1, 7, 40, 300}) {
+				big_integer x = (rng() % 2 == 0) ? -random_number(limbs) : random_number(limbs);
+				std::vector<uint> moduli(count);
+				for (uint &m : moduli) {
+					m = (rng() % 4 == 0) ? static_cast<uint>(1 + rng() % 1000) : static_cast<uint>(rng() | 1);
+				}
+				moduli[0] = 1;
+				std::vector<uint> got = multi_mod(x, moduli);
+				bool ok = got.size() == count;
+				for (size_t j = 0; ok && j != count; ++j) {
+					big_integer r = x % big_integer(moduli[j]);
+					ok = got[j] == ((r < 0) ? r + big_integer(moduli[j]) : r);
+				}
+				check(ok, "multi_mod, " + std::to_string(limbs) + " chunks, " + std::to_string(count) + " moduli");
+			}
+		}
+
+		big_integer x = random_signed(200);
+		std::vector<big_integer> moduli = {1, 2, random_number(3), random_number(20), random_number(150), random_number(250)};
+		for (int j = 0; j != 30; ++j) {
+			moduli.push_back(random_number(1 + rng() % 10));
+		}
+		std::vector<big_integer> got = multi_mod(x, moduli);
+		bool ok = got.size() == moduli.size();
+		for (size_t j = 0; ok && j != moduli.size(); ++j) {
+			big_integer r = x % moduli[j];
+			ok = got[j] == ((r < 0) ? r + moduli[j] : r);
+		}
+		check(ok, "multi_mod with big_integer moduli");
+
+		bool thrown = false;
+		try {
+			multi_mod(x, std::vector<uint>{3, 0, 5});
+		}
+		catch (std::runtime_error const &) {
+			thrown = true;
+		}
+		check(thrown, "multi_mod by 0");
+		thrown = false;
+		try {
+			multi_mod(x, std::vector<big_integer>{3, 0});
+		}
+		catch (std::runtime_error const &) {
+			thrown = true;
+		}
+		check(thrown, "multi_mod by a big_integer 0");
+	}
+
+	void test_divisor_1() {
+		std::vector<uint> divisors = {1, 2, 3, 7, 10, 1000000000, 0x7FFFFFFFu, 0x80000000u, 0x80000001u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+		for (int it = 0; it != 20; ++it) {
+			// every normalization shift, odd and even
+			uint d = static_cast<uint>(rng()) >> (it % 32);
+			divisors.push_back(d | 1);
+			divisors.push_back((d | 1) << (rng() % 8));
+		}
+
+		for (uint d : divisors) {
+			if (d == 0) {
+				continue;
+			}
+			limbs::divisor_1 divisor(d);
+			std::uint64_t normalized = static_cast<std::uint64_t>(d) << divisor.shift;
+			check(divisor.normalized == normalized && normalized >> 31 == 1
+				&& divisor.reciprocal == ~0ull / normalized - (1ull << 32), "divisor_1(" + std::to_string(d) + ") fields");
+			for (size_t n : {0, 1, 2, 5, 40}) {
+				std::vector<uint> a(n), q(n), expected(n);
+				for (uint &x : a) {
+					x = (rng() % 4 == 0) ? ~0u : static_cast<uint>(rng());
+				}
+				// schoolbook division by a word
+				std::uint64_t rem = 0;
+				for (size_t i = n; i--;) {
+					std::uint64_t cur = (rem << 32) | a[i];
+					expected[i] = static_cast<uint>(cur / d);
+					rem = cur % d;
+				}
+
+				std::string what = "divisor_1(" + std::to_string(d) + "), " + std::to_string(n) + " chunks";
+				check(limbs::divrem_1(q.data(), a.data(), n, divisor) == rem && q == expected, what + " divrem_1");
+				check(limbs::mod_1(a.data(), n, divisor) == rem, what + " mod_1");
+				check(limbs::divrem_1(q.data(), a.data(), n, d) == rem && q == expected, what + " divrem_1 by a word");
+				// in place
+				q = a;
+				check(limbs::divrem_1(q.data(), q.data(), n, divisor) == rem && q == expected, what + " in place");
+
+				big_integer x = from_chunks(a);
+				check(x / big_integer(d) == from_chunks(expected) && x % big_integer(d) == big_integer(static_cast<uint>(rem)),
+					what + " operator/ and operator%");
+			}
+		}
+
+		// decimal output divides by 10^9
+		big_integer power = 1;
+		std::string digits = "1";
+		for (int k = 0; k != 200; ++k) {
+			check(to_string(power) == digits && to_string(power - 1) == std::string(digits.size() - 1, '9') + (k == 0 ? "0" : ""),
+				"to_string(10^" + std::to_string(k) + ")");
+			power *= 10;
+			digits += '0';
+		}
+	}
+
+	void test_divexact() {
+		for (size_t limbs : {1, 3, 10, 40, 120}) {
+			for (int it = 0; it != 30; ++it) {
+				big_integer a = random_signed(limbs), b = random_signed(limbs);
+				big_integer c = a * b;
+				std::string what = "divexact/divisible_by, " + std::to_string(limbs) + " chunks";
+				check(divexact(c, b) == a, what);
+				check(divexact(c, b) == c / b, what);
+				check(divisible_by(c, b), what);
+				check(divisible_by(c + 1, b) == ((c + 1) % b == 0), what);
+				check(divisible_by(a, b) == (a % b == 0), what);
+			}
+		}
+
+		// divisors with more zero chunks than the dividend has chunks
+		check(divexact(big_integer(1), big_integer(1) << 64) == 0, "divexact(1, 2^64)");
+		check(divexact(big_integer(6) << 32, big_integer(3) << 96) == 0, "divexact(6 2^32, 3 2^96)");
+		check(divexact(big_integer(0), big_integer(7)) == 0, "divexact(0, 7)");
+		check(divisible_by(big_integer(0), big_integer(0)), "divisible_by(0, 0)");
+		check(!divisible_by(big_integer(5), big_integer(0)), "divisible_by(5, 0)");
+		check(!divisible_by(big_integer(1), big_integer(1) << 64), "divisible_by(1, 2^64)");
+	}
+
+	void test_serialize() {
+		std::vector<big_integer> values = {0, 1, -1, big_integer(1) << 32};
+		for (int it = 0; it != 50; ++it) {
+			values.push_back(random_signed(1 + rng() % 300));
+		}
+
+		std::vector<std::uint8_t> bytes;
+		for (big_integer const &x : values) {
+			check(deserialize(serialize(x)) == x, "serialize round trip");
+			std::vector<std::uint8_t> record = serialize(x);
+			check(record.size() == serialized_size(x), "serialized_size");
+			bytes.insert(bytes.end(), record.begin(), record.end());
+		}
+
+		// records back to back, read in place
+		auto owner = std::make_shared<std::vector<std::uint8_t>>(bytes);
+		std::uint8_t const *pos = owner->data(), *end = owner->data() + owner->size();
+		for (big_integer const &x : values) {
+			big_integer y;
+			pos = deserialize(y, pos, end, owner);
+			check(y == x, "deserialize in place");
+			y += 1;
+			check(y == x + 1, "deserialize in place, then change");
+		}
+		check(pos == end, "deserialize, records back to back");
+	}
+
+	// whether opening path, then reading every element, throws
+	bool rejects(std::string const &path) {
+		try {
+			mapped_big_integer_array array(path);
+			for (size_t i = 0; i != array.size(); ++i) {
+				(void)array[i];
+			}
+		}
+		catch (std::runtime_error const &) {
+			return true;
+		}
+		return false;
+	}
+
+	// overwrites size bytes at offset of path with value, little-endian
+	void patch(std::string const &path, size_t offset, std::uint64_t value, size_t size) {
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(static_cast<std::streamoff>(offset));
+		for (size_t k = 0; k != size; ++k) {
+			file.put(static_cast<char>(value >> (8 * k)));
+		}
+	}
+
+	void test_mapped_array() {
+		std::string const path = "test_bigint_opt.bigarr";
+		std::vector<big_integer> values = {0, 5, -5, big_integer(1) << 32, 0, -(big_integer(1) << 100)};
+		for (int it = 0; it != 40; ++it) {
+			values.push_back(random_signed(1 + rng() % 100));
+		}
+		write_big_integer_array(path, values);
+
+		std::vector<big_integer> kept;
+		{
+			mapped_big_integer_array array(path);
+			check(array.size() == values.size(), "mapped array size");
+			for (size_t i = 0; i != values.size(); ++i) {
+				check(array[i] == values[i], "mapped array element " + std::to_string(i));
+				check(array.signum(i) == ((values[i] < 0) ? -1 : (values[i] > 0) ? 1 : 0), "mapped array signum");
+				big_integer magnitude = (values[i] < 0) ? -values[i] : values[i];
+				std::vector<uint> chunks(array.chunks(i), array.chunks(i) + array.chunk_count(i));
+				check(from_chunks(chunks) == magnitude && (chunks.empty() || chunks.back() != 0), "mapped array chunks");
+				kept.push_back(array[i]);
+			}
+		}
+		// the elements outlive the array
+		for (size_t i = 0; i != values.size(); ++i) {
+			check(kept[i] == values[i], "mapped array element after the array is gone");
+			kept[i] += 1;
+			check(kept[i] == values[i] + 1, "mapped array element, changed");
+		}
+
+		kept.clear();
+		size_t count = values.size();
+		size_t offsets = 16, chunks = offsets + 8 * (count + 1) + (count + 7) / 8 * 8;
+		check(!rejects(path), "mapped array, intact file");
+		patch(path, 0, 'X', 1);
+		check(rejects(path), "mapped array, bad magic");
+		write_big_integer_array(path, values);
+		patch(path, 8, ~0ull, 8);
+		check(rejects(path), "mapped array, bad count");
+		write_big_integer_array(path, values);
+		patch(path, offsets + 8 * count, ~0ull >> 4, 8);
+		check(rejects(path), "mapped array, total beyond the file");
+		write_big_integer_array(path, values);
+		patch(path, offsets + 8 * 3, 1ull << 40, 8);
+		check(rejects(path), "mapped array, offset out of range");
+		write_big_integer_array(path, values);
+		patch(path, offsets + 8 * 3, 0, 8);
+		check(rejects(path), "mapped array, offsets going backwards");
+		write_big_integer_array(path, values);
+		patch(path, offsets + 8 * (count + 1) + 1, 7, 1);
+		check(rejects(path), "mapped array, bad sign byte");
+		// the top chunk of values[3] = 2^32 is 1
+		write_big_integer_array(path, values);
+		patch(path, chunks + 4 * 2 + 4, 0, 4);
+		check(rejects(path), "mapped array, leading zero chunk");
+		{
+			std::ofstream truncated(path, std::ios::binary | std::ios::trunc);
+			truncated << "BIGARR01";
+		}
+		check(rejects(path), "mapped array, truncated header");
+		check(rejects(path + ".missing"), "mapped array, missing file");
+		std::remove(path.c_str());
+	}
+
+	void test_input() {
+		for (int it = 0; it != 50; ++it) {
+			big_integer x = random_signed(1 + rng() % 200);
+			std::istringstream in(to_string(x) + " rest");
+			big_integer y;
+			in >> y;
+			std::string rest;
+			in >> rest;
+			check(in && y == x && rest == "rest", "operator>>, decimal");
+
+			std::string hex = "0x";
+			big_integer value = 0;
+			for (size_t i = 1 + rng() % 100; i--;) {
+				uint digit = rng() % 16;
+				hex += "0123456789abcdef"[digit];
+				value = value * 16 + digit;
+			}
+			std::istringstream hex_in("-" + hex + ";");
+			hex_in >> y;
+			check(hex_in && y == -value && hex_in.peek() == ';', "operator>>, hexadecimal");
+		}
+
+		std::istringstream bin_in("0b1011");
+		big_integer y;
+		bin_in >> y;
+		check(y == 11, "operator>>, binary");
+
+		std::istringstream bad("-x");
+		bad >> y;
+		check(bad.fail(), "operator>>, no digits");
+	}
+}
+
+int main() {
+	test_roots();
+	test_combinatorics();
+	test_pow();
+	test_primes();
+	test_bits();
+	test_expressions();
+	test_addmul();
+	test_accumulator();
+	test_fixed();
+	test_parallel_mul();
+	test_parallel_conversion();
+	test_batch();
+	test_ifma();
+	test_rns();
+	test_multi_mod();
+	test_divisor_1();
+	test_divexact();
+	test_serialize();
+	test_mapped_array();
+	test_input();
+
+	if (failures != 0) {
+		std::cout << failures << " checks failed\n";
+		return 1;
+	}
+	std::cout << "all checks passed\n";
+	return 0;
+}
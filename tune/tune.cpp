@@ -0,0 +1,165 @@
+// Measures the algorithm crossover points of bigint_opt on this machine and
+// prints bigint_opt_thresholds.h (see bigint_opt/tuning.h), in the spirit of
+// GMP's tuneup:
+//
+//     tune > bigint_opt/bigint_opt_thresholds.h
+//
+// This program is linked against its own copy of the library built with
+// TUNE_PROGRAM_BUILD, where the thresholds are variables. For every size n the
+// threshold is set to n (the faster algorithm is used for the top level only)
+// and to n + 1 (the simple one), and the threshold is the first size from which
+// the faster algorithm keeps winning.
+
+#include "big_integer.h"
+#include "ifma.h"
+#include "limbs.h"
+#include "tuning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tuning {
+	size_t karatsuba_mul_threshold = 32;
+	size_t karatsuba_sqr_threshold = 48;
+	size_t dc_conversion_threshold = 40;
+}
+
+namespace {
+	using uint = std::uint32_t;
+
+	// consecutive sizes the faster algorithm has to win before a threshold is accepted
+	constexpr int CONFIRM = 4;
+
+	double min_time = 0.002;
+	bool verbose = false;
+	volatile size_t sink;
+	std::mt19937 rng(12345);
+
+	std::vector<uint> random_chunks(size_t n) {
+		std::vector<uint> res(n);
+		for (uint &x : res) {
+			x = rng();
+		}
+		res.back() |= 1;
+		return res;
+	}
+
+	// seconds per call, best of several batches of at least min_time
+	template<typename F>
+	double time_call(F f) {
+		size_t reps = 1;
+		double best = 1e300;
+		for (int round = 0; round != 5;) {
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i != reps; ++i) {
+				f();
+			}
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (elapsed < min_time) {
+				reps *= 2;
+				continue;
+			}
+			best = std::min(best, elapsed / reps);
+			++round;
+		}
+		return best;
+	}
+
+	// first size n from which timing(n) with the threshold at n beats it with the
+	// threshold at n + 1, CONFIRM sizes in a row
+	template<typename Timing>
+	size_t find_threshold(char const *name, size_t &threshold, size_t from, size_t to, Timing timing) {
+		size_t saved = threshold;
+		size_t candidate = 0;
+		int wins = 0;
+		for (size_t n = from; n <= to; n += std::max<size_t>(1, n / 16)) {
+			threshold = n + 1;
+			double simple = timing(n);
+			threshold = n;
+			double fast = timing(n);
+			if (verbose) {
+				std::fprintf(stderr, "%s n=%zu simple=%.3gus fast=%.3gus\n", name, n, simple * 1e6, fast * 1e6);
+			}
+			if (fast < simple) {
+				if (wins++ == 0) {
+					candidate = n;
+				}
+				if (wins == CONFIRM) {
+					break;
+				}
+			}
+			else {
+				wins = 0;
+			}
+		}
+		threshold = saved;
+		size_t res = (wins == CONFIRM) ? candidate : to;
+		std::fprintf(stderr, "%s %zu\n", name, res);
+		return res;
+	}
+}
+
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-v") {
+			verbose = true;
+		}
+		else if (arg.compare(0, 11, "--min_time=") == 0) {
+			min_time = std::atof(arg.c_str() + 11);
+		}
+		else {
+			std::fprintf(stderr, "usage: tune [-v] [--min_time=<seconds per batch>] > bigint_opt_thresholds.h\n");
+			return 1;
+		}
+	}
+
+	// the thresholds are those of the scalar code, the IFMA ranges are fixed
+	ifma::select(false);
+
+	size_t mul = find_threshold("KARATSUBA_MUL_THRESHOLD", tuning::karatsuba_mul_threshold, 8, 400, [](size_t n) {
+		std::vector<uint> a = random_chunks(n), b = random_chunks(n), r(2 * n);
+		return time_call([&] { limbs::mul(r.data(), a.data(), n, b.data(), n); });
+	});
+	tuning::karatsuba_mul_threshold = mul;
+
+	size_t sqr = find_threshold("KARATSUBA_SQR_THRESHOLD", tuning::karatsuba_sqr_threshold, 8, 600, [](size_t n) {
+		std::vector<uint> a = random_chunks(n), r(2 * n);
+		return time_call([&] { limbs::sqr(r.data(), a.data(), n); });
+	});
+	tuning::karatsuba_sqr_threshold = sqr;
+
+	// numbers of n + 1 chunks, or 9 (n + 1) digits, are split when the threshold is n
+	size_t conversion = find_threshold("DC_CONVERSION_THRESHOLD", tuning::dc_conversion_threshold, 8, 1000, [](size_t n) {
+		std::vector<uint> chunks = random_chunks(n + 1);
+		big_integer a = big_integer(chunks.back());
+		for (size_t i = n; i--;) {
+			a = (a << 32) + big_integer(chunks[i]);
+		}
+		std::string s = std::to_string(rng() % 9 + 1);
+		while (s.size() != 9 * (n + 1)) {
+			s.push_back((char)('0' + rng() % 10));
+		}
+		return time_call([&] { sink = sink + to_string(a).size(); })
+			+ time_call([&] { sink = sink + big_integer(s).get_data_size(); });
+	});
+
+	char date[64];
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof date, "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+	std::printf("// generated by tune on %s\n", date);
+	std::printf("#ifndef BIGINT_OPT_THRESHOLDS_H\n#define BIGINT_OPT_THRESHOLDS_H\n\n");
+	std::printf("#define KARATSUBA_MUL_THRESHOLD %zu\n", mul);
+	std::printf("#define KARATSUBA_SQR_THRESHOLD %zu\n", sqr);
+	std::printf("#define DC_CONVERSION_THRESHOLD %zu\n", conversion);
+	std::printf("\n#endif // BIGINT_OPT_THRESHOLDS_H\n");
+	return 0;
+}